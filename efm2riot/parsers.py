@@ -57,6 +57,7 @@ def parse_cpus(sdk_directory, family, min_ram_size, min_flash_size):
             architecture = None
             mpu = False
             fpu = False
+            vdac = False
             irqs = {}
             max_irq = None
 
@@ -77,6 +78,8 @@ def parse_cpus(sdk_directory, family, min_ram_size, min_flash_size):
                             mpu = True
                         elif "__FPU_PRESENT" in line and "1" in line:
                             fpu = True
+                        elif "VDAC_PRESENT" in line:
+                            vdac = True
                     elif "Cortex-M4" in line:
                         architecture = "m4"
                     elif "Cortex-M3" in line:
@@ -128,6 +131,7 @@ def parse_cpus(sdk_directory, family, min_ram_size, min_flash_size):
                 "cpu_platform": cpu_platform,
                 "flash_size": flash_size,
                 "ram_size": ram_size,
+                "vdac": vdac,
             }
 
             family.update({
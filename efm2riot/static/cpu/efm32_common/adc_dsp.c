@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2017 Bas Stottelaar <basstottelaar@gmail.com>
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     cpu_efm32_common
+ * @{
+ *
+ * @file
+ * @brief       Signal processing of streamed ADC samples
+ *
+ * @author      Bas Stottelaar <basstottelaar@gmail.com>
+ *
+ * @}
+ */
+
+#include "cpu.h"
+
+#include "periph_conf.h"
+
+#include "adc_dsp.h"
+
+#if defined(MODULE_CMSIS_DSP) && (__FPU_PRESENT == 1)
+
+int adc_dsp_init(adc_dsp_t *dsp, size_t len, uint32_t rate)
+{
+    /* length must be a supported power of two */
+    if (len > ADC_DSP_MAX_LEN || (len & (len - 1)) != 0) {
+        return -1;
+    }
+
+    if (arm_rfft_fast_init_f32(&dsp->fft, len) != ARM_MATH_SUCCESS) {
+        return -1;
+    }
+
+    /* precompute the window, to reduce spectral leakage */
+    for (size_t i = 0; i < len; i++) {
+        dsp->window[i] = 0.5f - 0.5f * arm_cos_f32(
+            (2.0f * PI * i) / (len - 1));
+    }
+
+    dsp->len = len;
+    dsp->rate = rate;
+
+    return 0;
+}
+
+void adc_dsp_process(adc_dsp_t *dsp, const uint16_t *samples,
+                     adc_dsp_features_t *features)
+{
+    float32_t *input = dsp->input;
+    float32_t *output = dsp->output;
+    float32_t min, max;
+    uint32_t index;
+
+    for (size_t i = 0; i < dsp->len; i++) {
+        input[i] = (float32_t) samples[i];
+    }
+
+    /* remove the DC component */
+    arm_mean_f32(input, dsp->len, &features->mean);
+    arm_offset_f32(input, -features->mean, input, dsp->len);
+
+    /* time domain features */
+    arm_rms_f32(input, dsp->len, &features->rms);
+    arm_max_f32(input, dsp->len, &max, &index);
+    arm_min_f32(input, dsp->len, &min, &index);
+
+    features->peak = (max > -min) ? max : -min;
+
+    /* frequency domain features (the FFT overwrites the input) */
+    arm_mult_f32(input, dsp->window, input, dsp->len);
+    arm_rfft_fast_f32(&dsp->fft, input, output, 0);
+    arm_cmplx_mag_f32(output, input, dsp->len / 2);
+
+    /* the first bin contains the DC and Nyquist components, skip it */
+    arm_max_f32(&input[1], (dsp->len / 2) - 1, &features->magnitude, &index);
+
+    features->freq = ((index + 1) * (float32_t) dsp->rate) / dsp->len;
+}
+
+/**
+ * @brief   Process a completed half of the ADC stream.
+ */
+static void _done(void *arg, uint16_t *samples, size_t len)
+{
+    adc_dsp_t *dsp = (adc_dsp_t *) arg;
+    adc_dsp_features_t features;
+
+    (void) len;
+
+    adc_dsp_process(dsp, samples, &features);
+
+    dsp->cb(dsp->arg, &features);
+}
+
+int adc_dsp_stream(adc_dsp_t *dsp, adc_t line, adc_res_t res,
+                   const stream_conf_t *conf, uint16_t *buf,
+                   adc_dsp_cb_t cb, void *arg)
+{
+    dsp->cb = cb;
+    dsp->arg = arg;
+
+    return adc_stream(line, res, conf, dsp->rate, buf, dsp->len, _done, dsp);
+}
+
+#endif /* defined(MODULE_CMSIS_DSP) && (__FPU_PRESENT == 1) */
@@ -0,0 +1,507 @@
+/*
+ * Copyright (C) 2017 Bas Stottelaar <basstottelaar@gmail.com>
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     cpu_efm32_common
+ * @{
+ *
+ * @file
+ * @brief       Implementation of the reference-counted clock management
+ *
+ * @author      Bas Stottelaar <basstottelaar@gmail.com>
+ *
+ * @}
+ */
+
+#include "cpu.h"
+#include "irq.h"
+#include "assert.h"
+
+#include "periph_conf.h"
+
+#include "clk.h"
+
+#include "em_cmu.h"
+
+typedef struct {
+    CMU_Clock_TypeDef clock;        /**< acquired clock */
+    uint8_t count;                  /**< number of references */
+} clk_ref_t;
+
+/**
+ * @brief   Number of HF clock cycles of one HFRCO measurement (the maximum
+ *          value of the calibration counter).
+ */
+#define CAL_CYCLES          (_CMU_CALCNT_CALCNT_MASK >> _CMU_CALCNT_CALCNT_SHIFT)
+
+/**
+ * @brief   Maximum value of the HFRCO tuning.
+ */
+#define CAL_TUNING_MAX      (_CMU_HFRCOCTRL_TUNING_MASK >> _CMU_HFRCOCTRL_TUNING_SHIFT)
+
+/**
+ * @brief   Seconds to wait between measurements, once the HFRCO is within
+ *          tolerance. The wait is timed by counting down the LFXO.
+ */
+#define CAL_PERIOD_SEC      (16U)
+
+static clk_ref_t clk_refs[CLK_NUMOF];
+
+static volatile bool cal_enabled;
+
+static volatile bool cal_waiting;
+
+static clk_notifier_t *clk_notifiers;
+
+/**
+ * @brief   Find the reference of a clock, or a free one if requested.
+ */
+static clk_ref_t *_find(CMU_Clock_TypeDef clock, bool allocate)
+{
+    clk_ref_t *unused = NULL;
+
+    for (unsigned i = 0; i < CLK_NUMOF; i++) {
+        if (clk_refs[i].count == 0) {
+            if (unused == NULL) {
+                unused = &clk_refs[i];
+            }
+        }
+        else if (clk_refs[i].clock == clock) {
+            return &clk_refs[i];
+        }
+    }
+
+    if (allocate && unused != NULL) {
+        unused->clock = clock;
+        return unused;
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief   Acquire (or release) the branches of a clock, based on the
+ *          register that enables it.
+ */
+static void _branches(CMU_Clock_TypeDef clock, bool acquire)
+{
+    void (*fn)(CMU_Clock_TypeDef) = acquire ? clk_acquire : clk_release;
+
+    switch ((clock >> CMU_EN_REG_POS) & CMU_EN_REG_MASK) {
+        case CMU_HFPERCLKEN0_EN_REG:
+            fn(cmuClock_HFPER);
+            break;
+        case CMU_LFACLKEN0_EN_REG:
+            fn(cmuClock_CORELE);
+            fn(cmuClock_LFA);
+            break;
+        case CMU_LFBCLKEN0_EN_REG:
+            fn(cmuClock_CORELE);
+            fn(cmuClock_LFB);
+            break;
+#ifdef _SILICON_LABS_32B_PLATFORM_2
+        case CMU_LFECLKEN0_EN_REG:
+            fn(cmuClock_CORELE);
+            fn(cmuClock_LFE);
+            break;
+#endif
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief   Enable (or gate) a clock.
+ *
+ * The low-frequency branches do not have an enable bit, so they are gated by
+ * deselecting their clock source. Pending writes to the low-frequency domain
+ * are completed first, since they would not complete otherwise.
+ */
+static void _enable(CMU_Clock_TypeDef clock, bool enable)
+{
+    if (clock == cmuClock_LFA) {
+        while (!enable && CMU->SYNCBUSY) {}
+        CMU_ClockSelectSet(cmuClock_LFA, enable ? CLOCK_LFA : cmuSelect_Disabled);
+    }
+    else if (clock == cmuClock_LFB) {
+        while (!enable && CMU->SYNCBUSY) {}
+        CMU_ClockSelectSet(cmuClock_LFB, enable ? CLOCK_LFB : cmuSelect_Disabled);
+    }
+#ifdef _SILICON_LABS_32B_PLATFORM_2
+    else if (clock == cmuClock_LFE) {
+        while (!enable && CMU->SYNCBUSY) {}
+        CMU_ClockSelectSet(cmuClock_LFE, enable ? CLOCK_LFE : cmuSelect_Disabled);
+    }
+#endif
+    else {
+        CMU_ClockEnable(clock, enable);
+    }
+}
+
+/**
+ * @brief   Wait for the low-frequency oscillator of the branch of a clock.
+ *
+ * The LFXO may still be starting after boot or after EM2/EM3, which can take
+ * hundreds of milliseconds. Selecting a branch waits for its oscillator, so
+ * this is done before interrupts are disabled. The selection then completes
+ * immediately.
+ */
+static void _lf_wait(CMU_Clock_TypeDef clock)
+{
+    CMU_Select_TypeDef source;
+
+    if (clock == cmuClock_LFA) {
+        source = CLOCK_LFA;
+    }
+    else if (clock == cmuClock_LFB) {
+        source = CLOCK_LFB;
+    }
+#ifdef _SILICON_LABS_32B_PLATFORM_2
+    else if (clock == cmuClock_LFE) {
+        source = CLOCK_LFE;
+    }
+#endif
+    else {
+        switch ((clock >> CMU_EN_REG_POS) & CMU_EN_REG_MASK) {
+            case CMU_LFACLKEN0_EN_REG:
+                source = CLOCK_LFA;
+                break;
+            case CMU_LFBCLKEN0_EN_REG:
+                source = CLOCK_LFB;
+                break;
+#ifdef _SILICON_LABS_32B_PLATFORM_2
+            case CMU_LFECLKEN0_EN_REG:
+                source = CLOCK_LFE;
+                break;
+#endif
+            default:
+                return;
+        }
+    }
+
+    if (source == cmuSelect_LFXO) {
+        CMU_OscillatorEnable(cmuOsc_LFXO, true, true);
+    }
+    else if (source == cmuSelect_LFRCO) {
+        CMU_OscillatorEnable(cmuOsc_LFRCO, true, true);
+    }
+}
+
+void clk_gate_init(void)
+{
+    _enable(cmuClock_HFPER, false);
+    _enable(cmuClock_LFA, false);
+    _enable(cmuClock_LFB, false);
+#ifdef _SILICON_LABS_32B_PLATFORM_2
+    _enable(cmuClock_LFE, false);
+#endif
+}
+
+void clk_acquire(CMU_Clock_TypeDef clock)
+{
+    _lf_wait(clock);
+
+    unsigned int cpsr = irq_disable();
+
+    clk_ref_t *ref = _find(clock, true);
+
+    assert(ref != NULL);
+
+    if (ref->count++ == 0) {
+        _branches(clock, true);
+        _enable(clock, true);
+    }
+
+    irq_restore(cpsr);
+}
+
+void clk_release(CMU_Clock_TypeDef clock)
+{
+    unsigned int cpsr = irq_disable();
+
+    clk_ref_t *ref = _find(clock, false);
+
+    assert(ref != NULL);
+
+    if (--ref->count == 0) {
+        _enable(clock, false);
+        _branches(clock, false);
+    }
+
+    irq_restore(cpsr);
+}
+
+void clk_notifier_add(clk_notifier_t *notifier, void (*cb)(void *arg),
+                      void *arg)
+{
+    unsigned int cpsr = irq_disable();
+
+    clk_notifier_t **node = &clk_notifiers;
+
+    while (*node != NULL && *node != notifier) {
+        node = &(*node)->next;
+    }
+
+    if (*node == NULL) {
+        notifier->cb = cb;
+        notifier->arg = arg;
+        notifier->next = NULL;
+        *node = notifier;
+    }
+
+    irq_restore(cpsr);
+}
+
+void clk_notifier_remove(clk_notifier_t *notifier)
+{
+    unsigned int cpsr = irq_disable();
+
+    clk_notifier_t **node = &clk_notifiers;
+
+    while (*node != NULL && *node != notifier) {
+        node = &(*node)->next;
+    }
+
+    if (*node != NULL) {
+        *node = notifier->next;
+    }
+
+    irq_restore(cpsr);
+}
+
+void clk_notify(void)
+{
+    for (clk_notifier_t *notifier = clk_notifiers; notifier != NULL;
+         notifier = notifier->next) {
+        notifier->cb(notifier->arg);
+    }
+}
+
+/**
+ * @brief   Start a measurement of the HFRCO against the LFXO, or the wait
+ *          until the next one.
+ */
+static void _cal_start(bool wait)
+{
+    if (!cal_enabled || CMU_ClockSelectGet(cmuClock_HF) != cmuSelect_HFRCO) {
+        return;
+    }
+
+    unsigned int cpsr = irq_disable();
+
+#if defined(CMU_CMD_CALSTOP)
+    CMU_CalibrateStop();
+#endif
+
+#ifdef CMU_CALCTRL_DOWNSEL_LFXO
+    if (wait) {
+        /* count down the LFXO, only to time the wait */
+        CMU->CALCTRL = CMU_CALCTRL_UPSEL_LFXO | CMU_CALCTRL_DOWNSEL_LFXO;
+        CMU->CALCNT = CAL_PERIOD_SEC * SystemLFXOClockGet();
+    }
+    else
+#endif
+    {
+        /* count down the HF clock, and count up the LFXO meanwhile */
+        CMU->CALCTRL = CMU_CALCTRL_UPSEL_LFXO;
+        CMU->CALCNT = CAL_CYCLES;
+    }
+
+    cal_waiting = wait;
+
+    CMU_IntClear(CMU_IFC_CALRDY);
+    CMU_IntEnable(CMU_IEN_CALRDY);
+
+    CMU_CalibrateStart();
+
+    irq_restore(cpsr);
+}
+
+int clk_hf_set_hfrco(uint32_t freq)
+{
+#if defined(_CMU_HFRCOCTRL_BAND_MASK)
+    CMU_HFRCOBand_TypeDef band;
+
+    switch (freq) {
+        case 1000000U:
+            band = cmuHFRCOBand_1MHz;
+            break;
+        case 7000000U:
+            band = cmuHFRCOBand_7MHz;
+            break;
+        case 11000000U:
+            band = cmuHFRCOBand_11MHz;
+            break;
+        case 14000000U:
+            band = cmuHFRCOBand_14MHz;
+            break;
+        case 21000000U:
+            band = cmuHFRCOBand_21MHz;
+            break;
+#if defined(CMU_HFRCOCTRL_BAND_28MHZ)
+        case 28000000U:
+            band = cmuHFRCOBand_28MHz;
+            break;
+#endif
+        default:
+            return -1;
+    }
+#else
+    /* the bands are enumerated by their frequency */
+    CMU_HFRCOFreq_TypeDef band = (CMU_HFRCOFreq_TypeDef) freq;
+
+    switch (band) {
+        case cmuHFRCOFreq_1M0Hz:
+        case cmuHFRCOFreq_2M0Hz:
+        case cmuHFRCOFreq_4M0Hz:
+        case cmuHFRCOFreq_7M0Hz:
+        case cmuHFRCOFreq_13M0Hz:
+        case cmuHFRCOFreq_16M0Hz:
+        case cmuHFRCOFreq_19M0Hz:
+        case cmuHFRCOFreq_26M0Hz:
+        case cmuHFRCOFreq_32M0Hz:
+        case cmuHFRCOFreq_38M0Hz:
+            break;
+        default:
+            return -1;
+    }
+#endif
+
+    /* do not race with the HFXO being selected after waking up */
+    pm_hfxo_wait();
+
+    CMU_OscillatorEnable(cmuOsc_HFRCO, true, true);
+    CMU_HFRCOBandSet(band);
+    CMU_ClockSelectSet(cmuClock_HF, cmuSelect_HFRCO);
+    CMU_OscillatorEnable(cmuOsc_HFXO, false, false);
+
+    /* the tuning was reset to the factory value of the band */
+    _cal_start(false);
+
+    clk_notify();
+
+    return 0;
+}
+
+void clk_hf_set_hfxo(void)
+{
+    pm_hfxo_wait();
+
+    /* selecting the HFXO starts it, and waits until it is ready */
+    CMU_ClockSelectSet(cmuClock_HF, cmuSelect_HFXO);
+    CMU_OscillatorEnable(cmuOsc_HFRCO, false, false);
+
+    clk_notify();
+}
+
+void clk_core_div_set(CMU_ClkDiv_TypeDef div)
+{
+    pm_hfxo_wait();
+
+    CMU_ClockDivSet(cmuClock_CORE, div);
+
+    clk_notify();
+}
+
+void clk_hfrco_cal_enable(bool enable)
+{
+    /* measurements are discarded until the LFXO has started */
+    if (enable) {
+        CMU_OscillatorEnable(cmuOsc_LFXO, true, false);
+    }
+
+    cal_enabled = enable;
+
+    if (enable) {
+        NVIC_ClearPendingIRQ(CMU_IRQn);
+        NVIC_EnableIRQ(CMU_IRQn);
+
+        _cal_start(false);
+    }
+    else {
+        CMU_IntDisable(CMU_IEN_CALRDY);
+        cal_waiting = false;
+    }
+}
+
+void clk_hfrco_cal_restart(void)
+{
+    /* the wait between measurements is not affected */
+    if (!cal_waiting) {
+        _cal_start(false);
+    }
+}
+
+void clk_hfrco_cal_isr(void)
+{
+    CMU_IntClear(CMU_IFC_CALRDY);
+
+    if (!cal_enabled || CMU_ClockSelectGet(cmuClock_HF) != cmuSelect_HFRCO) {
+        /* restarted by clk_hf_set_hfrco, if enabled */
+        CMU_IntDisable(CMU_IEN_CALRDY);
+        cal_waiting = false;
+        return;
+    }
+
+    /* the wait has passed, so measure again */
+    if (cal_waiting) {
+        _cal_start(false);
+        return;
+    }
+
+    /* LFXO cycles expected during the measurement, at the nominal frequency
+       of the current HFRCO band */
+    uint32_t expected = (uint32_t) (((uint64_t) CAL_CYCLES *
+                                     SystemLFXOClockGet()) /
+                                    CMU_ClockFreqGet(cmuClock_HF));
+    uint32_t count = CMU_CalibrateCountGet();
+    uint32_t tolerance = expected / 512;
+    uint32_t tuning = CMU_OscillatorTuningGet(cmuOsc_HFRCO);
+    bool in_band = false;
+
+    /* the HFRCO is accurate to a few percent, so a larger difference means
+       the LFXO was not running during the measurement */
+    if (count > expected - (expected / 16) && count < expected + (expected / 16)) {
+        /* more LFXO cycles means the HFRCO is too slow. On Series 0, a higher
+           tuning value increases the frequency, on Series 1 it decreases it */
+#ifdef _SILICON_LABS_32B_PLATFORM_1
+        bool faster = true;
+#else
+        bool faster = false;
+#endif
+
+        if (count > expected + tolerance) {
+            tuning = faster ? tuning + 1 : tuning - 1;
+        }
+        else if (count < expected - tolerance) {
+            tuning = faster ? tuning - 1 : tuning + 1;
+        }
+        else {
+            in_band = true;
+        }
+
+        if (tuning <= CAL_TUNING_MAX) {
+            CMU_OscillatorTuningSet(cmuOsc_HFRCO, tuning);
+        }
+    }
+
+    /* measure back-to-back until the HFRCO is within tolerance, and wait
+       before measuring again afterwards */
+#ifdef CMU_CALCTRL_DOWNSEL_LFXO
+    _cal_start(in_band);
+#else
+    /* the counters cannot time the wait, so measure again after the next
+       restart (e.g. after EM2/EM3) */
+    if (in_band) {
+        CMU_IntDisable(CMU_IEN_CALRDY);
+    }
+    else {
+        CMU_CalibrateStart();
+    }
+#endif
+}
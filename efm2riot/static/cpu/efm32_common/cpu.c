@@ -19,12 +19,84 @@
  * @}
  */
 
+#include <string.h>
+
 #include "cpu.h"
+#include "irq.h"
 #include "periph_conf.h"
 
+#include "clk.h"
+#include "cpu_cycles.h"
+#include "cpu_load.h"
+#include "isr_profile.h"
+
 #include "em_chip.h"
 #include "em_cmu.h"
 #include "em_emu.h"
+#include "em_rmu.h"
+
+/**
+ * @brief   Cause of the last reset, captured during boot.
+ */
+static uint32_t reset_cause;
+
+#if BOOT_TRACE_ENABLED
+/**
+ * @brief   Duration of each boot stage, in core clock cycles.
+ */
+static uint32_t boot_cycles[CPU_BOOT_STAGE_NUMOF];
+
+/**
+ * @brief   Value of the SysTick at the end of the previous stage.
+ */
+static uint32_t boot_mark;
+
+/**
+ * @brief   Run the SysTick from the core clock, counting down from its
+ *          maximum value.
+ */
+static void boot_trace_start(void)
+{
+    SysTick->LOAD = SysTick_LOAD_RELOAD_Msk;
+    SysTick->VAL = 0;
+    SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_ENABLE_Msk;
+
+    boot_mark = SysTick->VAL;
+}
+
+/**
+ * @brief   Store the duration of a stage, which ends now.
+ */
+static void boot_trace(cpu_boot_stage_t stage)
+{
+    uint32_t now = SysTick->VAL;
+
+    boot_cycles[stage] = (boot_mark - now) & SysTick_LOAD_RELOAD_Msk;
+    boot_mark = now;
+}
+
+static void boot_trace_stop(void)
+{
+    SysTick->CTRL = 0;
+}
+#else
+#define boot_trace_start()
+#define boot_trace(stage)
+#define boot_trace_stop()
+#endif
+
+/**
+ * @brief   Start the low-frequency oscillator of a clock source, if any.
+ */
+static void lf_osc_start(CMU_Select_TypeDef source)
+{
+    if (source == cmuSelect_LFXO) {
+        CMU_OscillatorEnable(cmuOsc_LFXO, true, false);
+    }
+    else if (source == cmuSelect_LFRCO) {
+        CMU_OscillatorEnable(cmuOsc_LFRCO, true, false);
+    }
+}
 
 /**
  * @brief   Configure clock sources and the CPU frequency
@@ -33,28 +105,189 @@
  * source, using an external clock source (HFXO), or using the internal RC
  * oscillator (HFRCO, enabled by default).
  *
- * The clocks for the LFA, LFB, LFE and HFPER are also configured.
+ * The clocks for the LFA, LFB, LFE and HFPER are also configured. These
+ * branches are gated until a driver acquires them (see clk.h). Their
+ * oscillators are started here, but not waited for, since the LFXO can take
+ * hundreds of milliseconds to start.
  */
 static void clk_init(void)
 {
-    /* set the HF clock source */
-    CMU_ClockSelectSet(cmuClock_HF, CLOCK_HF);
+    /* set the HF clock source, or start the HFXO and keep running on the
+       HFRCO until it is ready */
+    if (PM_ASYNC_HFXO_ENABLED && CLOCK_HF == cmuSelect_HFXO) {
+        pm_hfxo_start();
+    }
+    else {
+        CMU_ClockSelectSet(cmuClock_HF, CLOCK_HF);
+
+        /* disable the HFRCO if external crystal is used */
+        if (CLOCK_HF == cmuSelect_HFXO) {
+            CMU_OscillatorEnable(cmuOsc_HFRCO, false, false);
+        }
+    }
+
     CMU_ClockDivSet(cmuClock_CORE, CLOCK_CORE_DIV);
 
-    /* disable the HFRCO if external crystal is used */
-    if (CLOCK_HF == cmuSelect_HFXO) {
-        CMU_OscillatorEnable(cmuOsc_HFRCO, false, false);
+    /* start the oscillators of the LFA, LFB and LFE clocks without waiting.
+       The sources are selected when the branches are acquired, which waits
+       until the oscillator is ready, if it is not yet (see clk.c) */
+    lf_osc_start(CLOCK_LFA);
+    lf_osc_start(CLOCK_LFB);
+#ifdef _SILICON_LABS_32B_PLATFORM_2
+    lf_osc_start(CLOCK_LFE);
+#endif
+
+    /* gate the branches until they are acquired */
+    clk_gate_init();
+
+#if HFRCO_CAL_ENABLED
+    /* keep the HFRCO accurate, if there is no HFXO to rely on */
+    if (CLOCK_HF == cmuSelect_HFRCO) {
+        clk_hfrco_cal_enable(true);
     }
+#endif
+}
+
+/**
+ * @brief   RAM blocks that can be powered down, in ascending order. Powering
+ *          down a block powers down the blocks above it (in the same
+ *          register) as well.
+ */
+typedef struct {
+    uint32_t start;                 /**< start address of the block */
+    volatile uint32_t *reg;         /**< power-down register */
+    uint32_t blocks;                /**< value of the register */
+} ram_block_t;
 
-    /* set the LFA clock source */
-    CMU_ClockSelectSet(cmuClock_LFA, CLOCK_LFA);
+#if defined(_EFM32_GIANT_FAMILY) && defined(_EMU_MEMCTRL_POWERDOWN_MASK)
+/* EFM32GG: four blocks of 32 KB */
+#define HAVE_RAM_BLOCKS
+static const ram_block_t ram_blocks[] = {
+    { 0x20008000, &EMU->MEMCTRL, EMU_MEMCTRL_POWERDOWN_BLK123 },
+    { 0x20010000, &EMU->MEMCTRL, EMU_MEMCTRL_POWERDOWN_BLK23 },
+    { 0x20018000, &EMU->MEMCTRL, EMU_MEMCTRL_POWERDOWN_BLK3 }
+};
+#elif defined(_SILICON_LABS_32B_SERIES_1_CONFIG_1)
+/* xG1: RAM0 has blocks of 4, 4, 8, 8 and 8 KB */
+#define HAVE_RAM_BLOCKS
+static const ram_block_t ram_blocks[] = {
+    { 0x20001000, &EMU->RAM0CTRL, EMU_RAM0CTRL_RAMPOWERDOWN_BLK1TO4 },
+    { 0x20002000, &EMU->RAM0CTRL, EMU_RAM0CTRL_RAMPOWERDOWN_BLK2TO4 },
+    { 0x20004000, &EMU->RAM0CTRL, EMU_RAM0CTRL_RAMPOWERDOWN_BLK3TO4 },
+    { 0x20006000, &EMU->RAM0CTRL, EMU_RAM0CTRL_RAMPOWERDOWN_BLK4 }
+};
+#elif defined(_SILICON_LABS_32B_SERIES_1_CONFIG_2)
+/* xG12: RAM0 has blocks of 16, 16, 32, 32 and 32 KB, RAM1 has two blocks of
+   64 KB. RAM2 is not part of the RAM used by the linker script, so it is left
+   powered (it is used by the radio). */
+#define HAVE_RAM_BLOCKS
+static const ram_block_t ram_blocks[] = {
+    { 0x20004000, &EMU->RAM0CTRL, EMU_RAM0CTRL_RAMPOWERDOWN_BLK1TO4 },
+    { 0x20008000, &EMU->RAM0CTRL, EMU_RAM0CTRL_RAMPOWERDOWN_BLK2TO4 },
+    { 0x20010000, &EMU->RAM0CTRL, EMU_RAM0CTRL_RAMPOWERDOWN_BLK3TO4 },
+    { 0x20018000, &EMU->RAM0CTRL, EMU_RAM0CTRL_RAMPOWERDOWN_BLK4 },
+    { 0x20020000, &EMU->RAM1CTRL, EMU_RAM1CTRL_RAMPOWERDOWN_BLK0TO1 },
+    { 0x20030000, &EMU->RAM1CTRL, EMU_RAM1CTRL_RAMPOWERDOWN_BLK1 }
+};
+#endif
 
-    /* set the LFB clock source */
-    CMU_ClockSelectSet(cmuClock_LFB, CLOCK_LFB);
+/**
+ * @brief   Power down the RAM blocks above the RAM in use
+ *
+ * The RAM in use ends at the end of the heap, which is the end of the RAM,
+ * unless it is limited by the linker script (see EFM32_RAM_LENGTH). Blocks
+ * that are powered down are not retained in any energy mode. The block
+ * layout is only known for the families above, so the RAM of other families
+ * stays powered.
+ */
+static void ram_init(void)
+{
+#ifdef HAVE_RAM_BLOCKS
+    extern uint32_t _eram_used;
+    unsigned numof = sizeof(ram_blocks) / sizeof(ram_blocks[0]);
 
-    /* set the LFE clock source */
-#ifdef _SILICON_LABS_32B_PLATFORM_2
-    CMU_ClockSelectSet(cmuClock_LFE, CLOCK_LFE);
+    /* the lowest unused block of each register is written last, since its
+       value includes the blocks above it */
+    for (unsigned i = numof; i-- > 0;) {
+        uint32_t start = ram_blocks[i].start;
+
+        if (start >= (uint32_t) &_eram_used && start < SRAM_BASE + SRAM_SIZE) {
+            *ram_blocks[i].reg = ram_blocks[i].blocks;
+        }
+    }
+#endif
+}
+
+/**
+ * @brief   Copy the RAM code section from flash (see EFM32_RAMFUNC)
+ *
+ * The section is linked before the data section, so it is not copied by the
+ * startup code.
+ */
+static void ramfunc_init(void)
+{
+    extern uint32_t _sramfunc[];
+    extern uint32_t _eramfunc[];
+    extern uint32_t _siramfunc[];
+
+    memcpy(_sramfunc, _siramfunc, (_eramfunc - _sramfunc) * sizeof(uint32_t));
+
+    /* complete the copy before any of it is executed */
+    __DSB();
+    __ISB();
+}
+
+#if RAM_VECTORS_ENABLED
+/**
+ * @brief   Number of entries of the vector table (the stack pointer, the
+ *          system exceptions and the peripheral interrupts).
+ */
+#define VECTORS_NUMOF       (16 + EXT_IRQ_COUNT)
+
+/**
+ * @brief   The vector table must be aligned to its size, rounded up to a
+ *          power of two (and at least 128 bytes).
+ */
+#define VECTORS_ALIGN       ((VECTORS_NUMOF > 64) ? 512 : \
+                             (VECTORS_NUMOF > 32) ? 256 : 128)
+
+static void *ram_vectors[VECTORS_NUMOF] __attribute__((aligned(VECTORS_ALIGN)));
+#endif
+
+/**
+ * @brief   Copy the vector table to RAM, and use it from now on
+ *
+ * Exceptions fetch their handler from RAM then, without flash wait states,
+ * and handlers can be replaced at runtime (see cpu_isr_register).
+ */
+static void vectors_init(void)
+{
+#if RAM_VECTORS_ENABLED
+    /* the table in flash is the active one, after cortexm_init */
+    memcpy(ram_vectors, (void *) SCB->VTOR, sizeof(ram_vectors));
+
+    SCB->VTOR = (uint32_t) ram_vectors;
+    __DSB();
+#endif
+}
+
+/**
+ * @brief   Configure the DC-DC converter, if the board has one
+ *
+ * The board configures the mode in EM0/1, and the expected load currents.
+ * In EM2/3/4, the converter switches to its low-power mode automatically.
+ * Boards without a DC-DC configuration keep the regulator setup of reset.
+ */
+static void dcdc_init(void)
+{
+#if defined(_EMU_DCDCCTRL_MASK) && defined(DCDC_MODE)
+    EMU_DCDCInit_TypeDef init_dcdc = EMU_DCDCINIT_DEFAULT;
+
+    init_dcdc.dcdcMode = DCDC_MODE;
+    init_dcdc.em01LoadCurrent_mA = DCDC_EM01_LOAD;
+    init_dcdc.em234LoadCurrent_uA = DCDC_EM234_LOAD;
+
+    EMU_DCDCInit(&init_dcdc);
 #endif
 }
 
@@ -66,21 +299,126 @@ static void pm_init(void)
     EMU_EM23Init(&init_em23);
 
 #ifdef _SILICON_LABS_32B_PLATFORM_2
-    /* initialize EM4 */
+    /* initialize EM4, in which the oscillator of the RTCC is kept running if
+       hibernating */
     EMU_EM4Init_TypeDef init_em4 = EMU_EM4INIT_DEFAULT;
 
+#if EM4_HIBERNATE_ENABLED
+    init_em4.em4State = emuEM4Hibernate;
+    init_em4.retainLfxo = (CLOCK_LFE == cmuSelect_LFXO);
+    init_em4.retainLfrco = (CLOCK_LFE == cmuSelect_LFRCO);
+#endif
+
     EMU_EM4Init(&init_em4);
 #endif
+
+    /* restore the state that was retained in EM4 */
+    pm_retained_restore();
 }
 
 void cpu_init(void)
 {
+    boot_trace_start();
+    /* copy the functions that execute from RAM */
+    ramfunc_init();
     /* apply errata that may be applicable (see em_chip.h) */
     CHIP_Init();
+    /* capture the reset cause, and clear it for the next reset */
+    reset_cause = RMU_ResetCauseGet();
+    RMU_ResetCauseClear();
+    /* power down the RAM that is not used */
+    ram_init();
+    boot_trace(CPU_BOOT_STAGE_CHIP);
     /* initialize the Cortex-M core */
     cortexm_init();
+    /* copy the vector table to RAM, if enabled */
+    vectors_init();
+    boot_trace(CPU_BOOT_STAGE_CORTEXM);
+    /* initialize the regulator, before the clocks speed up */
+    dcdc_init();
+    boot_trace(CPU_BOOT_STAGE_DCDC);
     /* initialize clock sources and generic clocks */
     clk_init();
+    boot_trace(CPU_BOOT_STAGE_CLK);
     /* initialize power management interface */
     pm_init();
+    boot_trace(CPU_BOOT_STAGE_PM);
+    boot_trace_stop();
+#if PM_STATS_ENABLED
+    /* the wake-up latency is measured in core clock cycles, after the
+       SysTick is released by the boot trace */
+    cpu_cycles_init();
+#endif
+#if CPU_LOAD_ENABLED
+    /* start measuring, after the SysTick is released by the boot trace */
+    cpu_load_init();
+#endif
+#if ISR_PROFILE_ENABLED
+    isr_profile_init();
+#endif
+}
+
+uint32_t cpu_reset_cause(void)
+{
+    return reset_cause;
+}
+
+bool cpu_woke_from_em4(void)
+{
+#ifdef RMU_RSTCAUSE_EM4RST
+    return (reset_cause & RMU_RSTCAUSE_EM4RST) != 0;
+#else
+    return false;
+#endif
+}
+
+cpu_regulator_mode_t cpu_regulator_mode(void)
+{
+#ifdef _EMU_DCDCCTRL_MASK
+    switch (EMU->DCDCCTRL & _EMU_DCDCCTRL_DCDCMODE_MASK) {
+        case EMU_DCDCCTRL_DCDCMODE_BYPASS:
+            return CPU_REGULATOR_DCDC_BYPASS;
+        case EMU_DCDCCTRL_DCDCMODE_LOWNOISE:
+            return CPU_REGULATOR_DCDC_LOW_NOISE;
+#ifdef EMU_DCDCCTRL_DCDCMODE_LOWPOWER
+        case EMU_DCDCCTRL_DCDCMODE_LOWPOWER:
+            return CPU_REGULATOR_DCDC_LOW_POWER;
+#endif
+        default:
+            return CPU_REGULATOR_LDO;
+    }
+#else
+    return CPU_REGULATOR_LDO;
+#endif
+}
+
+int cpu_isr_register(IRQn_Type irq, void (*isr)(void))
+{
+#if RAM_VECTORS_ENABLED
+    if (irq < 0 || irq >= EXT_IRQ_COUNT) {
+        return -1;
+    }
+
+    unsigned int cpsr = irq_disable();
+
+    ram_vectors[16 + irq] = (void *) isr;
+
+    irq_restore(cpsr);
+
+    return 0;
+#else
+    (void) irq;
+    (void) isr;
+    return -1;
+#endif
+}
+
+uint32_t cpu_boot_cycles(cpu_boot_stage_t stage)
+{
+#if BOOT_TRACE_ENABLED
+    return boot_cycles[stage];
+#else
+    (void) stage;
+    return 0;
+#endif
 }
@@ -0,0 +1,290 @@
+/*
+ * Copyright (C) 2017 Bas Stottelaar <basstottelaar@gmail.com>
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     cpu_efm32_common
+ * @{
+ *
+ * @file
+ * @brief       Implementation of the CPU load monitor
+ *
+ * @author      Bas Stottelaar <basstottelaar@gmail.com>
+ *
+ * @}
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "cpu.h"
+#include "irq.h"
+
+#include "periph_conf.h"
+
+#include "clk.h"
+#include "cpu_cycles.h"
+#include "cpu_load.h"
+
+#if CPU_LOAD_ENABLED
+
+#include "periph/rtt.h"
+
+/**
+ * @brief   Weights of the averages, as a power of two.
+ * @{
+ */
+#define AVG_16S_SHIFT       (4U)
+#define AVG_64S_SHIFT       (6U)
+/** @} */
+
+/**
+ * @brief   Fixed-point scale of the averages.
+ */
+#define AVG_SCALE           (1024)
+
+typedef struct {
+    uint32_t mark;                  /**< cycle counter at start of busy period */
+    uint32_t cycles;                /**< busy cycles, not converted yet */
+    uint32_t freq;                  /**< core clock frequency of the cycles */
+    uint64_t busy_ns;               /**< busy time, converted */
+    uint32_t window_mark;           /**< RTT counter at start of window */
+    uint64_t window_busy_ns;        /**< busy time at start of window */
+    uint32_t last_mark;             /**< RTT counter at previous query */
+    uint64_t last_busy_ns;          /**< busy time at previous query */
+    int32_t avg_1s;                 /**< load of the last window (scaled) */
+    int32_t avg_16s;                /**< average over 16 windows (scaled) */
+    int32_t avg_64s;                /**< average over 64 windows (scaled) */
+} cpu_load_state_t;
+
+static cpu_load_state_t state;
+
+static clk_notifier_t notifier;
+
+/**
+ * @brief   Add the cycles of the current busy period.
+ */
+static void _account(void)
+{
+    uint32_t now = cpu_cycles_get();
+
+    state.cycles += (now - state.mark) & CPU_CYCLES_MASK;
+    state.mark = now;
+}
+
+/**
+ * @brief   Convert the busy cycles to time, at the frequency they were
+ *          counted at.
+ */
+static void _convert(void)
+{
+    state.busy_ns += ((uint64_t) state.cycles * 1000000000U) / state.freq;
+    state.cycles = 0;
+    state.freq = SystemCoreClockGet();
+}
+
+/**
+ * @brief   Busy time relative to a number of RTT ticks, in permille.
+ */
+static uint32_t _permille(uint64_t busy_ns, uint32_t ticks)
+{
+    uint64_t total_ns = ((uint64_t) ticks * 1000000000U) / RTT_FREQUENCY;
+
+    if (total_ns == 0) {
+        return 0;
+    }
+
+    uint64_t permille = (busy_ns * 1000U) / total_ns;
+
+    return (permille > 1000) ? 1000 : (uint32_t) permille;
+}
+
+/**
+ * @brief   Update the averages, if at least one second has elapsed. If more
+ *          seconds have elapsed, the load was the same during each of them.
+ */
+static void _update(void)
+{
+    uint32_t now = rtt_get_counter();
+    uint32_t elapsed = (now - state.window_mark) & RTT_MAX_VALUE;
+
+    if (elapsed < RTT_FREQUENCY) {
+        return;
+    }
+
+    _convert();
+
+    int32_t load = _permille(state.busy_ns - state.window_busy_ns, elapsed) *
+                   AVG_SCALE;
+
+    state.avg_1s = load;
+
+    /* after 64 windows, the previous load has (almost) no weight anymore */
+    for (uint32_t i = 0; i < elapsed / RTT_FREQUENCY && i < 64; i++) {
+        state.avg_16s += (load - state.avg_16s) >> AVG_16S_SHIFT;
+        state.avg_64s += (load - state.avg_64s) >> AVG_64S_SHIFT;
+    }
+
+    state.window_mark = now;
+    state.window_busy_ns = state.busy_ns;
+}
+
+static void _clk_changed(void *arg)
+{
+    (void) arg;
+
+    unsigned int cpsr = irq_disable();
+
+    _account();
+    _convert();
+
+    irq_restore(cpsr);
+}
+
+void cpu_load_init(void)
+{
+    state.freq = SystemCoreClockGet();
+
+    cpu_cycles_init();
+
+    /* account the cycles on each SysTick wrap (2^24 cycles) as well, since
+       the core may stay busy for longer than the cycle counter takes to wrap
+       (see isr_systick). On Cortex-M0+, the SysTick is the cycle counter. On
+       Cortex-M3/M4, it only serves as periodic tick, because the DWT counter
+       wraps after 2^32 cycles (89 s at 48 MHz). */
+#if __CORTEX_M >= 3
+    SysTick->LOAD = SysTick_LOAD_RELOAD_Msk;
+    SysTick->VAL = 0;
+    SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_ENABLE_Msk;
+#endif
+    SysTick->CTRL |= SysTick_CTRL_TICKINT_Msk;
+
+    state.mark = cpu_cycles_get();
+
+    clk_notifier_add(&notifier, _clk_changed, NULL);
+}
+
+void cpu_load_sleep(void)
+{
+    _account();
+    _update();
+}
+
+void cpu_load_wake(void)
+{
+    state.mark = cpu_cycles_get();
+}
+
+void cpu_load_get(cpu_load_t *load)
+{
+    unsigned int cpsr = irq_disable();
+
+    _account();
+    _update();
+    _convert();
+
+    uint32_t now = rtt_get_counter();
+
+    load->last = _permille(state.busy_ns - state.last_busy_ns,
+                           (now - state.last_mark) & RTT_MAX_VALUE);
+    load->avg_1s = state.avg_1s / AVG_SCALE;
+    load->avg_16s = state.avg_16s / AVG_SCALE;
+    load->avg_64s = state.avg_64s / AVG_SCALE;
+    load->busy_us = state.busy_ns / 1000U;
+
+    state.last_mark = now;
+    state.last_busy_ns = state.busy_ns;
+
+    irq_restore(cpsr);
+}
+
+void cpu_load_reset(void)
+{
+    unsigned int cpsr = irq_disable();
+
+    _account();
+
+    uint32_t now = rtt_get_counter();
+
+    state.cycles = 0;
+    state.busy_ns = 0;
+    state.window_mark = now;
+    state.window_busy_ns = 0;
+    state.last_mark = now;
+    state.last_busy_ns = 0;
+    state.avg_1s = 0;
+    state.avg_16s = 0;
+    state.avg_64s = 0;
+
+    irq_restore(cpsr);
+}
+
+void isr_systick(void)
+{
+    /* interrupts are disabled while sleeping, so this is a busy period. The
+       cycles are converted as well, so they cannot overflow either. */
+    _account();
+    _convert();
+
+    cortexm_isr_end();
+}
+
+#else
+
+void cpu_load_init(void)
+{
+}
+
+void cpu_load_sleep(void)
+{
+}
+
+void cpu_load_wake(void)
+{
+}
+
+void cpu_load_get(cpu_load_t *load)
+{
+    memset(load, 0, sizeof(cpu_load_t));
+}
+
+void cpu_load_reset(void)
+{
+}
+
+#endif /* CPU_LOAD_ENABLED */
+
+int cpu_load_cmd(int argc, char **argv)
+{
+    cpu_load_t load;
+
+    if (argc > 2 || (argc == 2 && strcmp(argv[1], "reset") != 0)) {
+        printf("usage: %s [reset]\n", argv[0]);
+        return 1;
+    }
+
+    if (!CPU_LOAD_ENABLED) {
+        puts("CPU load monitor disabled (see CPU_LOAD_ENABLED)");
+        return 1;
+    }
+
+    if (argc == 2) {
+        cpu_load_reset();
+        return 0;
+    }
+
+    cpu_load_get(&load);
+
+    printf("load: %u.%u%% (1 s: %u.%u%%, 16 s: %u.%u%%, 64 s: %u.%u%%)\n",
+           (unsigned) load.last / 10, (unsigned) load.last % 10,
+           (unsigned) load.avg_1s / 10, (unsigned) load.avg_1s % 10,
+           (unsigned) load.avg_16s / 10, (unsigned) load.avg_16s % 10,
+           (unsigned) load.avg_64s / 10, (unsigned) load.avg_64s % 10);
+    printf("busy: %lu ms\n", (unsigned long) (load.busy_us / 1000U));
+
+    return 0;
+}
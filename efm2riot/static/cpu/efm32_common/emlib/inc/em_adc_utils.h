@@ -0,0 +1,44 @@
+/*
+ * Copyright (C) 2017 Bas Stottelaar <basstottelaar@gmail.com>
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+#ifndef __SILICON_LABS_EM_ADC_UTILS_H__
+#define __SILICON_LABS_EM_ADC_UTILS_H__
+
+#include "em_device.h"
+#if defined(ADC_COUNT) && (ADC_COUNT > 0)
+
+#include "em_adc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/***************************************************************************//**
+ * @brief
+ *   Factory calibration of the internal temperature sensor.
+ ******************************************************************************/
+typedef struct {
+  /** Temperature during calibration (in degrees Celsius). */
+  int32_t temp;
+
+  /** Temperature sensor sample during calibration (12 bit, 1.25V reference). */
+  int32_t tempRead;
+} ADC_TempCal_TypeDef;
+
+void ADC_TempCalGet(ADC_TempCal_TypeDef *cal);
+
+int32_t ADC_Sample2MilliCelsius(const ADC_TempCal_TypeDef *cal, uint32_t sample);
+
+uint32_t ADC_Sample2MilliVolt(uint32_t sample, uint32_t ref, uint8_t bits);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* defined(ADC_COUNT) && (ADC_COUNT > 0) */
+#endif /* __SILICON_LABS_EM_ADC_UTILS_H__ */
@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2017 Bas Stottelaar <basstottelaar@gmail.com>
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+#include "em_adc_utils.h"
+#if defined(ADC_COUNT) && (ADC_COUNT > 0)
+
+#include "em_adc.h"
+#include "em_assert.h"
+
+/***************************************************************************//**
+ * @brief
+ *   Temperature gradient of the internal temperature sensor, in 1/100 ADC
+ *   steps per degree Celsius (12 bit, 1.25V reference).
+ ******************************************************************************/
+#ifdef _SILICON_LABS_32B_PLATFORM_1
+#define ADC_TEMP_GRADIENT      (627)
+#else
+#define ADC_TEMP_GRADIENT      (601)
+#endif
+
+/***************************************************************************//**
+ * @brief
+ *   Read the factory calibration of the internal temperature sensor from the
+ *   device information page.
+ *
+ * @note
+ *   The calibration does not change, so it only has to be read once.
+ *
+ * @param[out] cal
+ *   Pointer to the calibration structure to fill.
+ ******************************************************************************/
+void ADC_TempCalGet(ADC_TempCal_TypeDef *cal)
+{
+  EFM_ASSERT(cal != NULL);
+
+  cal->temp = (DEVINFO->CAL & _DEVINFO_CAL_TEMP_MASK) >> _DEVINFO_CAL_TEMP_SHIFT;
+
+#ifdef _SILICON_LABS_32B_PLATFORM_1
+  cal->tempRead = (DEVINFO->ADC0CAL2 & _DEVINFO_ADC0CAL2_TEMP1V25_MASK)
+                  >> _DEVINFO_ADC0CAL2_TEMP1V25_SHIFT;
+#else
+  cal->tempRead = (DEVINFO->ADC0CAL3 & _DEVINFO_ADC0CAL3_TEMPREAD1V25_MASK)
+                  >> _DEVINFO_ADC0CAL3_TEMPREAD1V25_SHIFT;
+#endif
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Convert a sample of the internal temperature sensor to a temperature,
+ *   using integer arithmetic only.
+ *
+ * @note
+ *   The sample must be a 12 bit sample, taken with the 1.25V reference.
+ *
+ * @param[in] cal
+ *   Calibration structure, as filled by ADC_TempCalGet.
+ *
+ * @param[in] sample
+ *   The 12 bit temperature sensor sample.
+ *
+ * @return
+ *   Temperature in milli degrees Celsius.
+ ******************************************************************************/
+int32_t ADC_Sample2MilliCelsius(const ADC_TempCal_TypeDef *cal, uint32_t sample)
+{
+  EFM_ASSERT(cal != NULL);
+  EFM_ASSERT(sample <= 0xFFF);
+
+  return (cal->temp * 1000)
+         + (((cal->tempRead - (int32_t) sample) * 100000) / ADC_TEMP_GRADIENT);
+}
+
+/***************************************************************************//**
+ * @brief
+ *   Convert a sample to a voltage, using integer arithmetic only.
+ *
+ * @param[in] sample
+ *   The sample to convert.
+ *
+ * @param[in] ref
+ *   Reference voltage of the channel (in mV).
+ *
+ * @param[in] bits
+ *   Resolution of the sample (in bits, at most 16).
+ *
+ * @return
+ *   Voltage in mV.
+ ******************************************************************************/
+uint32_t ADC_Sample2MilliVolt(uint32_t sample, uint32_t ref, uint8_t bits)
+{
+  EFM_ASSERT(bits <= 16);
+  EFM_ASSERT(ref <= 0xFFFF);
+
+  return (sample * ref) >> bits;
+}
+
+#endif /* defined(ADC_COUNT) && (ADC_COUNT > 0) */
@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2017 Bas Stottelaar <basstottelaar@gmail.com>
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     cpu_efm32_common
+ * @{
+ *
+ * @file
+ * @brief       Signal processing of streamed ADC samples
+ *
+ * Extracts features (mean, RMS, peak and dominant frequency) from each
+ * completed half of an ADC stream, using CMSIS-DSP. Only the features are
+ * reported, not the samples.
+ *
+ * This requires a CPU with FPU, and the cmsis-dsp package.
+ *
+ * @author      Bas Stottelaar <basstottelaar@gmail.com>
+ */
+
+#ifndef ADC_DSP_H
+#define ADC_DSP_H
+
+#include "periph_cpu.h"
+
+#if defined(MODULE_CMSIS_DSP) && (__FPU_PRESENT == 1)
+
+#include "arm_math.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   Maximum number of samples per block (must be a power of two).
+ */
+#ifndef ADC_DSP_MAX_LEN
+#define ADC_DSP_MAX_LEN     (256U)
+#endif
+
+/**
+ * @brief   Features of one block of samples.
+ */
+typedef struct {
+    float32_t mean;         /**< mean value (DC component) */
+    float32_t rms;          /**< RMS value, without DC component */
+    float32_t peak;         /**< largest deviation from the mean */
+    float32_t freq;         /**< dominant frequency (in Hz) */
+    float32_t magnitude;    /**< magnitude of the dominant frequency */
+} adc_dsp_features_t;
+
+/**
+ * @brief   Callback for the features of each block, in interrupt context.
+ */
+typedef void (*adc_dsp_cb_t)(void *arg, const adc_dsp_features_t *features);
+
+/**
+ * @brief   Signal processing context.
+ */
+typedef struct {
+    arm_rfft_fast_instance_f32 fft;         /**< FFT instance */
+    float32_t window[ADC_DSP_MAX_LEN];      /**< precomputed Hann window */
+    float32_t input[ADC_DSP_MAX_LEN];       /**< work buffer for samples */
+    float32_t output[ADC_DSP_MAX_LEN];      /**< work buffer for spectrum */
+    size_t len;                             /**< number of samples per block */
+    uint32_t rate;                          /**< sample rate (in Hz) */
+    adc_dsp_cb_t cb;                        /**< callback for features */
+    void *arg;                              /**< argument passed to callback */
+} adc_dsp_t;
+
+/**
+ * @brief   Initialize a signal processing context.
+ *
+ * @param[out] dsp      context to initialize
+ * @param[in] len       number of samples per block (power of two, 32 up to
+ *                      ADC_DSP_MAX_LEN)
+ * @param[in] rate      sample rate (in Hz)
+ *
+ * @return              0 on success
+ * @return              -1 on invalid length
+ */
+int adc_dsp_init(adc_dsp_t *dsp, size_t len, uint32_t rate);
+
+/**
+ * @brief   Extract the features of one block of samples.
+ *
+ * @param[in] dsp       initialized context
+ * @param[in] samples   block of samples
+ * @param[out] features extracted features
+ */
+void adc_dsp_process(adc_dsp_t *dsp, const uint16_t *samples,
+                     adc_dsp_features_t *features);
+
+/**
+ * @brief   Start an ADC stream, and report the features of each block.
+ *
+ * @param[in] dsp       initialized context
+ * @param[in] line      ADC line to sample
+ * @param[in] res       resolution to use
+ * @param[in] conf      stream configuration
+ * @param[in] buf       double buffer of 2 * len samples
+ * @param[in] cb        callback for features
+ * @param[in] arg       argument passed to the callback
+ *
+ * @return              0 on success
+ * @return              -1 on error
+ */
+int adc_dsp_stream(adc_dsp_t *dsp, adc_t line, adc_res_t res,
+                   const stream_conf_t *conf, uint16_t *buf,
+                   adc_dsp_cb_t cb, void *arg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* defined(MODULE_CMSIS_DSP) && (__FPU_PRESENT == 1) */
+
+#endif /* ADC_DSP_H */
+/** @} */
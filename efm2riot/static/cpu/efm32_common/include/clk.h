@@ -0,0 +1,179 @@
+/*
+ * Copyright (C) 2017 Bas Stottelaar <basstottelaar@gmail.com>
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     cpu_efm32_common
+ * @{
+ *
+ * @file
+ * @brief       Reference-counted clock management
+ *
+ * Drivers acquire the clock of a peripheral while it is active, and release
+ * it afterwards. Acquiring a clock acquires the branch it is part of as well
+ * (HFPER for high-frequency peripherals, and CORELE plus LFA, LFB or LFE for
+ * low-energy peripherals). A clock is gated as soon as it is not acquired
+ * anymore, and so is a branch.
+ *
+ * The low-frequency oscillators are started during boot, but not waited for.
+ * Acquiring a low-frequency branch for the first time waits until its
+ * oscillator is ready. The oscillators keep running when their branch is
+ * gated, so acquiring it again does not wait for an oscillator to start.
+ *
+ * The HF clock can be changed at runtime, e.g. to process at a low frequency
+ * and to speed up for bursts of work. Drivers that derive dividers from the
+ * HF clock (UART, SPI, I2C, timers and PWM) register a notifier, and update
+ * their dividers when the HF clock changes. Since they are updated in place,
+ * change the frequency while no transfer is in progress.
+ *
+ * The HFRCO can be trimmed against the LFXO, so it is accurate enough for
+ * UARTs and timers without an HFXO (see clk_hfrco_cal_enable).
+ *
+ * @author      Bas Stottelaar <basstottelaar@gmail.com>
+ */
+
+#ifndef CLK_H
+#define CLK_H
+
+#include "em_cmu.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   Maximum number of clocks (including branches) that can be
+ *          acquired at the same time.
+ */
+#ifndef CLK_NUMOF
+#define CLK_NUMOF           (24U)
+#endif
+
+/**
+ * @brief   Notifier, called when the frequency of the HF clock has changed.
+ */
+typedef struct clk_notifier {
+    struct clk_notifier *next;      /**< next notifier in the list */
+    void (*cb)(void *arg);          /**< callback, may be in interrupt context */
+    void *arg;                      /**< argument passed to the callback */
+} clk_notifier_t;
+
+/**
+ * @brief   Gate the branches, until they are acquired.
+ *
+ * This is called once during boot, after the clock sources are selected.
+ */
+void clk_gate_init(void);
+
+/**
+ * @brief   Acquire a clock, and enable it (and its branch) if it was not
+ *          acquired before.
+ *
+ * If the clock is in a low-frequency branch of which the oscillator is still
+ * starting, this waits for it with interrupts enabled.
+ *
+ * @param[in] clock     clock to acquire
+ */
+void clk_acquire(CMU_Clock_TypeDef clock);
+
+/**
+ * @brief   Release a clock, and gate it (and its branch) if it is not
+ *          acquired anymore.
+ *
+ * @param[in] clock     clock to release
+ */
+void clk_release(CMU_Clock_TypeDef clock);
+
+/**
+ * @brief   Add a notifier, which is called each time the HF clock has changed.
+ *          Has no effect if it is in the list already.
+ *
+ * @param[in] notifier  notifier to add (must remain valid until removed)
+ * @param[in] cb        callback (must not be NULL)
+ * @param[in] arg       argument passed to the callback
+ */
+void clk_notifier_add(clk_notifier_t *notifier, void (*cb)(void *arg),
+                      void *arg);
+
+/**
+ * @brief   Remove a notifier. Has no effect if it is not in the list.
+ *
+ * @param[in] notifier  notifier to remove
+ */
+void clk_notifier_remove(clk_notifier_t *notifier);
+
+/**
+ * @brief   Call the notifiers, after the HF clock has changed.
+ */
+void clk_notify(void);
+
+/**
+ * @brief   Run the HF clock from the HFRCO, at the given frequency. The HFXO
+ *          is disabled.
+ *
+ * The supported frequencies are the HFRCO bands of the MCU (e.g. 1, 7, 11,
+ * 14, 21 or 28 MHz on Series 0, and 1, 2, 4, 7, 13, 16, 19, 26, 32 or 38 MHz
+ * on Series 1). The flash wait states are adjusted by emlib.
+ *
+ * @param[in] freq      frequency of the HFRCO, in Hz
+ *
+ * @return              0 on success
+ * @return              -1 if the frequency is not an HFRCO band
+ */
+int clk_hf_set_hfrco(uint32_t freq);
+
+/**
+ * @brief   Run the HF clock from the HFXO again. The HFRCO is disabled.
+ *
+ * This waits until the HFXO has started.
+ */
+void clk_hf_set_hfxo(void);
+
+/**
+ * @brief   Set the divider of the core clock.
+ *
+ * @param[in] div       divider (e.g. cmuClkDiv_1)
+ */
+void clk_core_div_set(CMU_ClkDiv_TypeDef div);
+
+/**
+ * @brief   Start (or stop) trimming the HFRCO against the LFXO.
+ *
+ * The calibration counters measure the HF clock against the LFXO, and the
+ * tuning of the HFRCO is adjusted by one step after each measurement that
+ * is off by more than approximately 0.2%. A measurement takes 2^20 HF clock
+ * cycles (e.g. 55 ms at 19 MHz). Measurements run back-to-back until the
+ * HFRCO is within tolerance, and then once every 16 seconds (timed by the
+ * same counters, which count down the LFXO meanwhile). On the EFM32G, the
+ * counters cannot time this wait, so the next measurement starts after the
+ * next restart instead. The LFXO is enabled if it was not.
+ *
+ * @param[in] enable    true to start trimming, false to stop
+ */
+void clk_hfrco_cal_enable(bool enable);
+
+/**
+ * @brief   Discard the current measurement, and start a new one.
+ *
+ * This is called after the HF clock was stopped (e.g. in EM2/EM3) or was
+ * changed, since a measurement spanning that would be wrong. It has no
+ * effect if trimming is not enabled, or while waiting for the next
+ * measurement.
+ */
+void clk_hfrco_cal_restart(void);
+
+/**
+ * @brief   Handle a completed measurement (called from isr_cmu).
+ */
+void clk_hfrco_cal_isr(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CLK_H */
+/** @} */
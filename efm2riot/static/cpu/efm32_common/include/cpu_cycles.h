@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2017 Bas Stottelaar <basstottelaar@gmail.com>
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     cpu_efm32_common
+ * @{
+ *
+ * @file
+ * @brief       Core clock cycle counter, for measurements
+ *
+ * The DWT cycle counter is used on Cortex-M3/M4. The Cortex-M0+ has none,
+ * so the SysTick is used instead, which wraps after 2^24 cycles. Differences
+ * between two readings must be masked with CPU_CYCLES_MASK.
+ *
+ * @author      Bas Stottelaar <basstottelaar@gmail.com>
+ */
+
+#ifndef CPU_CYCLES_H
+#define CPU_CYCLES_H
+
+#include <stdint.h>
+
+#include "cpu.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if (__CORTEX_M >= 3) || defined(DOXYGEN)
+/**
+ * @brief   Mask of the counter value.
+ */
+#define CPU_CYCLES_MASK     (0xffffffff)
+
+/**
+ * @brief   Start the counter, if it is not running yet.
+ */
+static inline void cpu_cycles_init(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+/**
+ * @brief   Read the counter, which counts up.
+ *
+ * @return              number of cycles (wraps at CPU_CYCLES_MASK)
+ */
+static inline uint32_t cpu_cycles_get(void)
+{
+    return DWT->CYCCNT;
+}
+#else
+#define CPU_CYCLES_MASK     (SysTick_LOAD_RELOAD_Msk)
+
+static inline void cpu_cycles_init(void)
+{
+    if (!(SysTick->CTRL & SysTick_CTRL_ENABLE_Msk)) {
+        SysTick->LOAD = SysTick_LOAD_RELOAD_Msk;
+        SysTick->VAL = 0;
+        SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_ENABLE_Msk;
+    }
+}
+
+static inline uint32_t cpu_cycles_get(void)
+{
+    /* the SysTick counts down */
+    return CPU_CYCLES_MASK - SysTick->VAL;
+}
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CPU_CYCLES_H */
+/** @} */
@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2017 Bas Stottelaar <basstottelaar@gmail.com>
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     cpu_efm32_common
+ * @{
+ *
+ * @file
+ * @brief       CPU load monitor
+ *
+ * The time the core is busy is measured in core clock cycles, between
+ * waking up and entering the next power mode in pm_set. The cycles are
+ * counted by the DWT cycle counter (Cortex-M3/M4), or by the SysTick
+ * (Cortex-M0+). The elapsed time is measured by the RTT, since the core
+ * clock stops in EM2/EM3. Interrupts are part of the busy time. The SysTick
+ * interrupt accounts the busy cycles periodically, so the counter does not
+ * wrap during long busy periods.
+ *
+ * This requires CPU_LOAD_ENABLED to be set, and the RTT to be initialized
+ * (see rtt_init). The averages are updated once per second, so the RTT
+ * frequency should be higher than 1 Hz.
+ *
+ * @author      Bas Stottelaar <basstottelaar@gmail.com>
+ */
+
+#ifndef CPU_LOAD_H
+#define CPU_LOAD_H
+
+#include <stdint.h>
+
+#include "periph_cpu.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   CPU load, in permille.
+ */
+typedef struct {
+    uint32_t last;          /**< load since the previous cpu_load_get */
+    uint32_t avg_1s;        /**< load during the last complete second */
+    uint32_t avg_16s;       /**< average over approximately 16 seconds */
+    uint32_t avg_64s;       /**< average over approximately 64 seconds */
+    uint64_t busy_us;       /**< total busy time, in microseconds */
+} cpu_load_t;
+
+/**
+ * @brief   Start measuring (called by cpu_init).
+ */
+void cpu_load_init(void);
+
+/**
+ * @brief   Account the busy time, before the core sleeps (called by pm_set).
+ */
+void cpu_load_sleep(void);
+
+/**
+ * @brief   Start a busy period, after the core woke up (called by pm_set).
+ */
+void cpu_load_wake(void);
+
+/**
+ * @brief   Get the CPU load.
+ *
+ * @param[out] load     CPU load (all zero if CPU_LOAD_ENABLED is not set)
+ */
+void cpu_load_get(cpu_load_t *load);
+
+/**
+ * @brief   Reset the averages and the total busy time.
+ */
+void cpu_load_reset(void);
+
+/**
+ * @brief   Shell command that prints the CPU load.
+ *
+ * Add it to the shell commands of an application, e.g.
+ * `{ "load", "Print the CPU load", cpu_load_cmd }`. Pass `reset` to reset
+ * the averages.
+ *
+ * @param[in] argc      number of arguments
+ * @param[in] argv      arguments
+ *
+ * @return              0 on success
+ * @return              1 on invalid arguments
+ */
+int cpu_load_cmd(int argc, char **argv);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CPU_LOAD_H */
+/** @} */
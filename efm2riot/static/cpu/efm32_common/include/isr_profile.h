@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2017 Bas Stottelaar <basstottelaar@gmail.com>
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     cpu_efm32_common
+ * @{
+ *
+ * @file
+ * @brief       Interrupt handler profiling
+ *
+ * If ISR_PROFILE_ENABLED is set, each peripheral interrupt handler in the
+ * vector table is wrapped by a probe, which measures how often it runs and
+ * how long it takes, in core clock cycles. The duration of a handler
+ * includes the handlers that preempted it.
+ *
+ * The latency of an interrupt cannot be measured directly. Instead, the
+ * longest time it was pending while another handler ran is recorded, which
+ * is a lower bound of its worst-case latency (time with interrupts disabled
+ * is not seen).
+ *
+ * @author      Bas Stottelaar <basstottelaar@gmail.com>
+ */
+
+#ifndef ISR_PROFILE_H
+#define ISR_PROFILE_H
+
+#include <stdint.h>
+
+#include "periph_cpu.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   Number of words of the NVIC pending registers that are in use.
+ */
+#define ISR_PROFILE_WORDS   ((EXT_IRQ_COUNT + 31) / 32)
+
+/**
+ * @brief   Define a probe, which wraps the handler of an interrupt.
+ *
+ * This is used by the vector table.
+ *
+ * @param[in] name      name of the interrupt handler
+ * @param[in] irq       interrupt number
+ */
+#define ISR_PROFILE_PROBE(name, irq) \
+    static void name ## _probe(void) \
+    { \
+        isr_profile_probe_t probe; \
+        isr_profile_enter(&probe); \
+        name(); \
+        isr_profile_exit(&probe, irq); \
+    }
+
+/**
+ * @brief   State of a probe, while its handler runs.
+ */
+typedef struct {
+    uint32_t start;                         /**< cycle counter at entry */
+    uint32_t pending[ISR_PROFILE_WORDS];    /**< interrupts pending at entry */
+} isr_profile_probe_t;
+
+/**
+ * @brief   Profile of an interrupt handler. Durations are in cycles.
+ */
+typedef struct {
+    uint32_t count;         /**< number of times the handler ran */
+    uint32_t max;           /**< longest duration */
+    uint64_t total;         /**< total duration */
+    uint32_t latency;       /**< longest time pending while another ran */
+} isr_profile_t;
+
+/**
+ * @brief   Names of the interrupts (NULL if reserved), generated with the
+ *          vector table.
+ */
+extern const char *const isr_profile_names[EXT_IRQ_COUNT];
+
+/**
+ * @brief   Start the cycle counter (called by cpu_init).
+ */
+void isr_profile_init(void);
+
+/**
+ * @brief   Called by a probe, before its handler runs.
+ *
+ * @param[out] probe    state of the probe
+ */
+void isr_profile_enter(isr_profile_probe_t *probe);
+
+/**
+ * @brief   Called by a probe, after its handler ran.
+ *
+ * @param[in] probe     state of the probe
+ * @param[in] irq       interrupt number
+ */
+void isr_profile_exit(isr_profile_probe_t *probe, unsigned irq);
+
+/**
+ * @brief   Get the profile of an interrupt handler.
+ *
+ * @param[in] irq       interrupt number
+ * @param[out] profile  profile (all zero if ISR_PROFILE_ENABLED is not set)
+ *
+ * @return              0 on success
+ * @return              -1 if the interrupt number is invalid
+ */
+int isr_profile_get(unsigned irq, isr_profile_t *profile);
+
+/**
+ * @brief   Reset the profiles of all interrupt handlers.
+ */
+void isr_profile_reset(void);
+
+/**
+ * @brief   Shell command that prints the profiles of the handlers that ran.
+ *
+ * Add it to the shell commands of an application, e.g.
+ * `{ "isr", "Print the interrupt profiles", isr_profile_cmd }`. Pass `reset`
+ * to reset the profiles.
+ *
+ * @param[in] argc      number of arguments
+ * @param[in] argv      arguments
+ *
+ * @return              0 on success
+ * @return              1 on invalid arguments
+ */
+int isr_profile_cmd(int argc, char **argv);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ISR_PROFILE_H */
+/** @} */
@@ -46,14 +46,141 @@ extern "C" {
 #endif
 /** @} */
 
+/**
+ * @brief   Use the BURTC for the RTC and RTT (if supported by CPU), so they
+ *          keep counting in EM4.
+ * @{
+ */
+#ifndef BURTC_ENABLED
+#define BURTC_ENABLED       (0)
+#endif
+/** @} */
+
+/**
+ * @brief   Resume from EM2/EM3 on the HFRCO, and switch back to the HFXO in
+ *          the background, once it is ready (if the HFXO is the HF clock).
+ * @{
+ */
+#ifndef PM_ASYNC_HFXO_ENABLED
+#define PM_ASYNC_HFXO_ENABLED   (0)
+#endif
+/** @} */
+
+/**
+ * @brief   Trim the HFRCO against the LFXO in the background, if the HFRCO is
+ *          the HF clock (see clk_hfrco_cal_enable).
+ * @{
+ */
+#ifndef HFRCO_CAL_ENABLED
+#define HFRCO_CAL_ENABLED   (0)
+#endif
+/** @} */
+
+/**
+ * @brief   Measure the duration of the boot stages in cpu_init (see
+ *          cpu_boot_cycles), using the SysTick.
+ * @{
+ */
+#ifndef BOOT_TRACE_ENABLED
+#define BOOT_TRACE_ENABLED  (0)
+#endif
+/** @} */
+
+/**
+ * @brief   Use EM4 hibernate (EM4H) instead of EM4 shutoff (if supported by
+ *          CPU), which keeps the RTCC and its oscillator running, so it can
+ *          wake up the MCU.
+ * @{
+ */
+#ifndef EM4_HIBERNATE_ENABLED
+#define EM4_HIBERNATE_ENABLED   (0)
+#endif
+/** @} */
+
+/**
+ * @brief   Record the time spent in each energy mode, the interrupts that wake
+ *          up the MCU and the wake-up latency (see pm_stats_get), using the
+ *          RTT counter and the cycle counter.
+ * @{
+ */
+#ifndef PM_STATS_ENABLED
+#define PM_STATS_ENABLED    (0)
+#endif
+/** @} */
+
+/**
+ * @brief   Measure the CPU load (see cpu_load.h), using the cycle counter and
+ *          the RTT counter.
+ * @{
+ */
+#ifndef CPU_LOAD_ENABLED
+#define CPU_LOAD_ENABLED    (0)
+#endif
+/** @} */
+
+/**
+ * @brief   Wrap the peripheral interrupt handlers with probes, that measure
+ *          their duration (see isr_profile.h).
+ * @{
+ */
+#ifndef ISR_PROFILE_ENABLED
+#define ISR_PROFILE_ENABLED (0)
+#endif
+/** @} */
+
+/**
+ * @brief   Copy the vector table to RAM during boot, so interrupt handlers can
+ *          be registered at runtime (see cpu_isr_register).
+ * @{
+ */
+#ifndef RAM_VECTORS_ENABLED
+#define RAM_VECTORS_ENABLED (0)
+#endif
+/** @} */
+
+/**
+ * @brief   Execute the interrupt handlers of the GPIO, timer and UART drivers
+ *          from RAM (see EFM32_RAMFUNC), on MCUs with at least 16 KB of RAM.
+ * @{
+ */
+#ifndef RAMFUNC_ENABLED
+#if SRAM_SIZE >= 0x4000
+#define RAMFUNC_ENABLED     (1)
+#else
+#define RAMFUNC_ENABLED     (0)
+#endif
+#endif
+/** @} */
+
+/**
+ * @brief   Override the ADC line type, so it can be used below.
+ * @{
+ */
+#define HAVE_ADC_T
+typedef unsigned int adc_t;
+/** @} */
+
 /**
  * @brief   Internal macro for combining ADC resolution (x) with number of
  *          shifts (y).
  */
 #define ADC_MODE(x, y)     ((y << 4) | x)
 
+/**
+ * @brief   Internal macro for combining ADC oversampling rate (x) with number
+ *          of shifts (y).
+ *
+ * The hardware accumulates the oversampled conversions into a result of at
+ * most 16 bits. The number of shifts reduces this to the requested resolution.
+ */
+#define ADC_MODE_OVS(x, y) ((x << 8) | ADC_MODE(adcResOVS, y))
+
 /**
  * @brief   Possible ADC resolution settings
+ *
+ * Resolutions above 12 bit are achieved using hardware oversampling, which
+ * takes 4^n samples for n extra bits (e.g. 256 samples for 16 bit). This
+ * increases the conversion time accordingly.
  * @{
  */
 #define HAVE_ADC_RES_T
@@ -62,6 +189,10 @@ typedef enum {
     ADC_RES_8BIT = ADC_MODE(adcRes8Bit, 0),     /**< ADC resolution: 8 bit */
     ADC_RES_10BIT = ADC_MODE(adcRes12Bit, 2),   /**< ADC resolution: 10 bit (shifted from 12 bit) */
     ADC_RES_12BIT = ADC_MODE(adcRes12Bit, 0),   /**< ADC resolution: 12 bit */
+    ADC_RES_13BIT = ADC_MODE_OVS(adcOvsRateSel4, 1),    /**< ADC resolution: 13 bit (4x oversampling) */
+    ADC_RES_14BIT = ADC_MODE_OVS(adcOvsRateSel16, 2),   /**< ADC resolution: 14 bit (16x oversampling) */
+    ADC_RES_15BIT = ADC_MODE_OVS(adcOvsRateSel64, 1),   /**< ADC resolution: 15 bit (64x oversampling) */
+    ADC_RES_16BIT = ADC_MODE_OVS(adcOvsRateSel256, 0),  /**< ADC resolution: 16 bit (256x oversampling) */
 } adc_res_t;
 /** @} */
 
@@ -91,6 +222,14 @@ typedef struct {
  */
 #define CPUID_LEN           (8U)
 
+/**
+ * @brief   Override the DAC line type, so it can be used below.
+ * @{
+ */
+#define HAVE_DAC_T
+typedef unsigned int dac_t;
+/** @} */
+
 /**
  * @brief   DAC device configuration
  * @{
@@ -106,9 +245,240 @@ typedef struct {
     uint8_t index;          /**< channel index */
     DAC_Ref_TypeDef ref;    /**< channel voltage reference */
 } dac_chan_conf_t;
+#elif defined(VDAC_COUNT) && VDAC_COUNT > 0
+typedef struct {
+    VDAC_TypeDef *dev;      /**< VDAC device used */
+    CMU_Clock_TypeDef cmu;  /**< the device CMU channel */
+    uint32_t ref;           /**< device voltage reference (VDAC_CTRL_REFSEL_x) */
+    bool low_power;         /**< keep output active in EM2/EM3 */
+} dac_conf_t;
+
+typedef struct {
+    uint8_t dev;            /**< device index */
+    uint8_t index;          /**< channel index */
+} dac_chan_conf_t;
 #endif
 /** @} */
 
+/**
+ * @brief   Maximum number of transfers per half of a DMA double buffer.
+ */
+#ifndef DMA_STREAM_MAX_LEN
+#define DMA_STREAM_MAX_LEN  (1024U)
+#endif
+
+/**
+ * @brief   DMA stream direction.
+ */
+typedef enum {
+    DMA_PERIPH_TO_MEM,      /**< read from peripheral into buffer */
+    DMA_MEM_TO_PERIPH       /**< write from buffer into peripheral */
+} dma_dir_t;
+
+/**
+ * @brief   DMA transfer width.
+ */
+typedef enum {
+    DMA_WIDTH_BYTE = 0,     /**< transfer 8 bits at a time */
+    DMA_WIDTH_HALFWORD = 1, /**< transfer 16 bits at a time */
+    DMA_WIDTH_WORD = 2      /**< transfer 32 bits at a time */
+} dma_width_t;
+
+/**
+ * @brief   Callback for a completed half of a DMA double buffer.
+ *
+ * The callback is called in interrupt context, with a pointer to the half
+ * that is ready. It must be processed before the other half completes.
+ */
+typedef void (*dma_cb_t)(void *arg, void *buf);
+
+/**
+ * @brief   Stream a peripheral from or to a circular double buffer.
+ *
+ * The buffer must hold two halves of @p len transfers of @p width each. The
+ * transfer continues until @ref dma_stop is called.
+ *
+ * @param[in] channel   DMA channel to use
+ * @param[in] dir       transfer direction
+ * @param[in] signal    peripheral request signal (DMAREQ_* or
+ *                      ldmaPeripheralSignal_*)
+ * @param[in] periph    peripheral data register
+ * @param[in] buf       double buffer
+ * @param[in] len       number of transfers per half
+ * @param[in] width     width of each transfer
+ * @param[in] cb        callback for each completed half
+ * @param[in] arg       argument passed to the callback
+ *
+ * @return              0 on success
+ * @return              -1 on invalid channel or length
+ */
+int dma_stream(uint8_t channel, dma_dir_t dir, uint32_t signal,
+               volatile void *periph, void *buf, size_t len, dma_width_t width,
+               dma_cb_t cb, void *arg);
+
+/**
+ * @brief   Stop a DMA stream.
+ *
+ * @param[in] channel   DMA channel to stop
+ */
+void dma_stop(uint8_t channel);
+
+/**
+ * @brief   Stream configuration, for pacing a peripheral with a TIMER.
+ *
+ * The TIMER overflow is routed to the peripheral using a PRS channel. The
+ * source must match the TIMER (e.g. PRS_CH_CTRL_SOURCESEL_TIMER2).
+ */
+typedef struct {
+    TIMER_TypeDef *dev;     /**< TIMER device used for pacing */
+    CMU_Clock_TypeDef cmu;  /**< the TIMER CMU channel */
+    uint32_t prs_source;    /**< PRS source of the TIMER */
+    uint8_t prs_channel;    /**< PRS channel used for pacing */
+    uint8_t dma_channel;    /**< DMA channel used for transfers */
+} stream_conf_t;
+
+/**
+ * @brief   Start pacing a PRS channel at a given rate.
+ *
+ * @param[in] conf      stream configuration
+ * @param[in] rate      rate in Hz
+ *
+ * @return              0 on success
+ * @return              -1 if the rate cannot be achieved
+ */
+int stream_timer_start(const stream_conf_t *conf, uint32_t rate);
+
+/**
+ * @brief   Stop pacing a PRS channel.
+ *
+ * @param[in] conf      stream configuration
+ */
+void stream_timer_stop(const stream_conf_t *conf);
+
+/**
+ * @brief   Callback for a completed half of an ADC stream, in interrupt
+ *          context.
+ */
+typedef void (*adc_stream_cb_t)(void *arg, uint16_t *samples, size_t len);
+
+/**
+ * @brief   Continuously sample an ADC line at a given rate, using DMA.
+ *
+ * The line must be initialized using adc_init() first. The ADC is reserved
+ * until @ref adc_stream_stop is called. Samples are scaled to the requested
+ * resolution, similar to adc_sample().
+ *
+ * @param[in] line      ADC line to sample
+ * @param[in] res       resolution to use
+ * @param[in] conf      stream configuration
+ * @param[in] rate      sample rate in Hz
+ * @param[in] buf       double buffer of 2 * @p len samples
+ * @param[in] len       number of samples per half
+ * @param[in] cb        callback for each completed half
+ * @param[in] arg       argument passed to the callback
+ *
+ * @return              0 on success
+ * @return              -1 on invalid line, configuration or rate
+ */
+int adc_stream(adc_t line, adc_res_t res, const stream_conf_t *conf,
+               uint32_t rate, uint16_t *buf, size_t len,
+               adc_stream_cb_t cb, void *arg);
+
+/**
+ * @brief   Stop a stream started by @ref adc_stream.
+ *
+ * @param[in] line      ADC line being sampled
+ * @param[in] conf      stream configuration
+ */
+void adc_stream_stop(adc_t line, const stream_conf_t *conf);
+
+/**
+ * @brief   Callback for a completed half of a DAC stream, in interrupt
+ *          context. The half can be refilled with new samples.
+ */
+typedef void (*dac_stream_cb_t)(void *arg, uint16_t *samples, size_t len);
+
+/**
+ * @brief   Continuously output samples on a DAC line at a given rate, using
+ *          DMA.
+ *
+ * The line must be initialized using dac_init() first. The buffer is output
+ * circularly, so a periodic waveform does not need a callback. Samples are
+ * written to the DAC as-is, and must be within the range of the DAC.
+ *
+ * @param[in] line      DAC line to output on
+ * @param[in] conf      stream configuration
+ * @param[in] rate      sample rate in Hz
+ * @param[in] buf       double buffer of 2 * @p len samples
+ * @param[in] len       number of samples per half
+ * @param[in] cb        callback for each completed half (may be NULL)
+ * @param[in] arg       argument passed to the callback
+ *
+ * @return              0 on success
+ * @return              -1 on invalid line, configuration or rate
+ */
+int dac_stream(dac_t line, const stream_conf_t *conf, uint32_t rate,
+               uint16_t *buf, size_t len, dac_stream_cb_t cb, void *arg);
+
+/**
+ * @brief   Stop a stream started by @ref dac_stream.
+ *
+ * @param[in] line      DAC line being output on
+ * @param[in] conf      stream configuration
+ */
+void dac_stream_stop(dac_t line, const stream_conf_t *conf);
+
+/**
+ * @brief   Get the RTT counter, extended to 64 bits by counting overflows.
+ *
+ * Overflows are counted from rtt_init() onwards. The read is consistent, and
+ * safe to call from any context (including interrupts), without locking.
+ *
+ * @return              64-bit counter value, in RTT_FREQUENCY ticks
+ */
+uint64_t rtt_get_counter64(void);
+
+#if !(BURTC_ENABLED && defined(BURTC_COUNT)) || defined(DOXYGEN)
+/**
+ * @brief   Software RTT alarm.
+ *
+ * The alarms are kept in a sorted list, and the first one is programmed in a
+ * dedicated compare channel. This channel is separate from the one used by
+ * rtt_set_alarm().
+ *
+ * Not available if the BURTC is used for the RTT (see BURTC_ENABLED), since
+ * it has a single compare channel.
+ */
+typedef struct rtt_alarm {
+    struct rtt_alarm *next;     /**< next alarm in the list */
+    uint64_t target;            /**< deadline, in 64-bit counter ticks */
+    void (*cb)(void *arg);      /**< callback called when the alarm expires */
+    void *arg;                  /**< argument passed to the callback */
+} rtt_alarm_t;
+
+/**
+ * @brief   Schedule a software RTT alarm.
+ *
+ * The callback is called in interrupt context, once the 64-bit counter
+ * (see @ref rtt_get_counter64) reaches the deadline. A deadline in the past
+ * expires immediately. The alarm must not be in the list already.
+ *
+ * @param[in] alarm     alarm to schedule (must remain valid until expired)
+ * @param[in] target    deadline, in 64-bit counter ticks
+ * @param[in] cb        callback (must not be NULL)
+ * @param[in] arg       argument passed to the callback
+ */
+void rtt_alarm_add(rtt_alarm_t *alarm, uint64_t target,
+                   void (*cb)(void *arg), void *arg);
+
+/**
+ * @brief   Cancel a software RTT alarm. Has no effect if it is not scheduled.
+ *
+ * @param[in] alarm     alarm to cancel
+ */
+void rtt_alarm_remove(rtt_alarm_t *alarm);
+#endif
+
 /**
  * @brief   Define a custom type for GPIO pins.
  * @{
@@ -173,6 +543,40 @@ typedef enum {
 } gpio_flank_t;
 /** @} */
 
+/**
+ * @brief   Enable wake-up from EM4 (see pm_off) by a GPIO pin.
+ *
+ * Only a few pins can wake up the MCU from EM4 (refer to the reference
+ * manual). The pin is configured as input, and retained during EM4. Waking
+ * up from EM4 resets the MCU, which can be detected using cpu_woke_from_em4.
+ *
+ * @param[in] pin       pin to use
+ * @param[in] mode      input mode to use
+ * @param[in] level     wake up on a high level (1) or low level (0)
+ *
+ * @return              0 on success
+ * @return              -1 if the pin cannot wake up the MCU from EM4
+ */
+int gpio_init_em4_wakeup(gpio_t pin, gpio_mode_t mode, int level);
+
+/**
+ * @brief   Disable wake-up from EM4 by a GPIO pin.
+ *
+ * @param[in] pin       pin to disable
+ */
+void gpio_em4_wakeup_disable(gpio_t pin);
+
+/**
+ * @brief   Check if a GPIO pin caused the last wake-up from EM4.
+ *
+ * This information is only available on MCUs that record the wake-up cause.
+ *
+ * @param[in] pin       pin to check
+ *
+ * @return              true if the pin woke up the MCU, false otherwise
+ */
+bool gpio_em4_wakeup_cause(gpio_t pin);
+
 /**
  * @brief   Override hardware crypto supported methods.
  * @{
@@ -330,6 +734,225 @@ typedef struct {
  */
 #define PM_NUM_MODES    (3U)
 
+/**
+ * @brief   Power modes, as used by pm_set and pm_block.
+ *
+ * Blocking a mode prevents entering that mode and deeper ones. Therefore,
+ * drivers block EFM32_PM_MODE_EM2 while a high-frequency peripheral is
+ * active, and EFM32_PM_MODE_EM3 while a low-energy peripheral is active.
+ * @{
+ */
+#define EFM32_PM_MODE_EM3   (0U)    /**< EM3, asynchronous peripherals only */
+#define EFM32_PM_MODE_EM2   (1U)    /**< EM2, low-energy peripherals run */
+#define EFM32_PM_MODE_EM1   (2U)    /**< EM1, all peripherals run */
+/** @} */
+
+/**
+ * @brief   No power modes are blocked initially, since the drivers block the
+ *          modes they cannot operate in.
+ */
+#define PM_BLOCKER_INITIAL  { .val_u32 = 0x00000000 }
+
+/**
+ * @brief   Place a variable in the retained section, which is kept in the
+ *          retention registers while the MCU is in EM4.
+ *
+ * The section is restored during boot after waking up from EM4, and zeroed
+ * after any other reset. It is limited to 128 bytes. Retention is supported
+ * by MCUs with an RTCC, and by MCUs with a BURTC if BURTC_ENABLED is set.
+ * The RTCC keeps its retention registers in EM4H only, so pm_off enters EM4H
+ * if this section is not empty, regardless of EM4_HIBERNATE_ENABLED.
+ * Otherwise, using this results in a linker error.
+ */
+#if (defined(RTCC_COUNT) && RTCC_COUNT > 0) || \
+    (defined(BURTC_COUNT) && BURTC_COUNT > 0 && BURTC_ENABLED) || \
+    defined(DOXYGEN)
+#define EFM32_RETAINED      __attribute__((section(".retained")))
+#else
+/* no retention registers, which the linker script reports as an error */
+#define EFM32_RETAINED      __attribute__((section(".retained_unavailable")))
+#endif
+
+/**
+ * @brief   Place a function in the RAM code section, so it executes without
+ *          flash wait states, and while the flash is being written.
+ *
+ * The section is copied to RAM by cpu_init. Functions called from it still
+ * execute from flash, unless they are inlined or placed in RAM as well. Has
+ * no effect if RAMFUNC_ENABLED is not set.
+ */
+#if RAMFUNC_ENABLED
+#define EFM32_RAMFUNC       __attribute__((section(".ramfunc")))
+#else
+#define EFM32_RAMFUNC
+#endif
+
+/**
+ * @brief   Copy the retained section to the retention registers.
+ *
+ * This is called by pm_off, before entering EM4.
+ */
+void pm_retained_save(void);
+
+/**
+ * @brief   Restore the retained section after waking up from EM4, or zero it
+ *          after any other reset.
+ *
+ * This is called by cpu_init.
+ */
+void pm_retained_restore(void);
+
+/**
+ * @brief   Start the HFXO, and select it as the HF clock in the background,
+ *          once it is ready.
+ *
+ * This is used during boot and after waking up from EM2/EM3, if
+ * PM_ASYNC_HFXO_ENABLED is set.
+ */
+void pm_hfxo_start(void);
+
+/**
+ * @brief   Wait until the HFXO is the HF clock again, if it is still starting
+ *          after waking up from EM2/EM3.
+ *
+ * Drivers call this before computing dividers from the HF clock frequency,
+ * or before starting timing-critical transfers. It returns immediately if
+ * the HFXO is selected already, and can be called with interrupts disabled.
+ */
+void pm_hfxo_wait(void);
+
+/**
+ * @brief   Index of EM0 in pm_stats_t::residency, after the power modes.
+ */
+#define PM_STATS_EM0            (PM_NUM_MODES)
+
+/**
+ * @brief   Number of bins of the wake-up latency histogram.
+ */
+#define PM_STATS_LATENCY_BINS   (16U)
+
+/**
+ * @brief   Residency of a power mode in which the RTT does not count.
+ */
+#define PM_STATS_UNAVAILABLE    (UINT32_MAX)
+
+/**
+ * @brief   Energy mode statistics, collected by pm_set.
+ *
+ * Residencies are in RTT ticks. The RTT stops in EM3 (unless the BURTC is
+ * used, see BURTC_ENABLED), so the EM3 residency is PM_STATS_UNAVAILABLE
+ * then, and the time spent in EM3 is not included anywhere.
+ *
+ * The wake-up latency is the time from leaving a power mode until the clocks
+ * are restored, which includes waiting for the HFXO (unless
+ * PM_ASYNC_HFXO_ENABLED is set). It is measured in microseconds, using the
+ * cycle counter. Bin 0 of the histogram counts wake-ups that took less than
+ * 1 us, and bin n wake-ups that took 2^(n - 1) us or more (but less than
+ * 2^n us, except for the last bin).
+ */
+typedef struct {
+    uint32_t residency[PM_NUM_MODES + 1];       /**< ticks per power mode */
+    uint32_t entries[PM_NUM_MODES];             /**< entries per power mode */
+    uint32_t wakeups[EXT_IRQ_COUNT];            /**< wake-ups per IRQ */
+    uint32_t latency[PM_STATS_LATENCY_BINS];    /**< latency histogram */
+} pm_stats_t;
+
+/**
+ * @brief   Get the energy mode statistics, collected since boot or since
+ *          pm_stats_reset.
+ *
+ * The statistics are only collected if PM_STATS_ENABLED is set, and the RTT
+ * is initialized (see rtt_init). The RTT frequency determines the resolution
+ * of the residencies.
+ *
+ * @param[out] dest     statistics (all zero if PM_STATS_ENABLED is not set)
+ */
+void pm_stats_get(pm_stats_t *dest);
+
+/**
+ * @brief   Reset the energy mode statistics.
+ */
+void pm_stats_reset(void);
+
+/**
+ * @brief   Get the cause of the last reset.
+ *
+ * The reset cause is captured (and cleared) by cpu_init.
+ *
+ * @return              the RMU_RSTCAUSE_* flags (see RMU_ResetCauseGet)
+ */
+uint32_t cpu_reset_cause(void);
+
+/**
+ * @brief   Check if the MCU was reset by leaving EM4 (a warm boot).
+ *
+ * Initialization code can use this to skip work of which the result is
+ * retained during EM4 (e.g. configuration of external components).
+ *
+ * @return              true if woken up from EM4, false otherwise
+ */
+bool cpu_woke_from_em4(void);
+
+/**
+ * @brief   Register the handler of a peripheral interrupt, replacing the one
+ *          in the vector table.
+ *
+ * This requires RAM_VECTORS_ENABLED to be set. The handler must call
+ * cortexm_isr_end() before it returns, like the handlers of the drivers.
+ *
+ * @param[in] irq       interrupt to register the handler for
+ * @param[in] isr       interrupt handler
+ *
+ * @return              0 on success
+ * @return              -1 if the interrupt number is invalid, or if the
+ *                      vector table is not in RAM
+ */
+int cpu_isr_register(IRQn_Type irq, void (*isr)(void));
+
+/**
+ * @brief   Regulator that powers the digital core.
+ */
+typedef enum {
+    CPU_REGULATOR_LDO = 0,              /**< internal LDO (no DC-DC) */
+    CPU_REGULATOR_DCDC_BYPASS,          /**< DC-DC bypassed (switch closed) */
+    CPU_REGULATOR_DCDC_LOW_NOISE,       /**< DC-DC in low-noise mode */
+    CPU_REGULATOR_DCDC_LOW_POWER        /**< DC-DC in low-power mode */
+} cpu_regulator_mode_t;
+
+/**
+ * @brief   Get the active mode of the regulator in EM0/1.
+ *
+ * The DC-DC converter is configured during boot, if the board provides a
+ * DC-DC configuration (see DCDC_MODE).
+ *
+ * @return              the active regulator mode
+ */
+cpu_regulator_mode_t cpu_regulator_mode(void);
+
+/**
+ * @brief   Stages of cpu_init, of which the duration is traced.
+ */
+typedef enum {
+    CPU_BOOT_STAGE_CHIP = 0,            /**< errata, reset cause and RAM */
+    CPU_BOOT_STAGE_CORTEXM,             /**< Cortex-M core */
+    CPU_BOOT_STAGE_DCDC,                /**< DC-DC converter */
+    CPU_BOOT_STAGE_CLK,                 /**< clock sources */
+    CPU_BOOT_STAGE_PM,                  /**< energy modes */
+    CPU_BOOT_STAGE_NUMOF                /**< number of stages */
+} cpu_boot_stage_t;
+
+/**
+ * @brief   Get the duration of a boot stage, in core clock cycles.
+ *
+ * The oscillators are started in the background during boot, so waiting
+ * for them is not part of these stages.
+ *
+ * @param[in] stage     boot stage
+ *
+ * @return              number of cycles, or 0 if BOOT_TRACE_ENABLED is not set
+ */
+uint32_t cpu_boot_cycles(cpu_boot_stage_t stage);
+
 #ifdef __cplusplus
 }
 #endif
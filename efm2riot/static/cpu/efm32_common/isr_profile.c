@@ -0,0 +1,175 @@
+/*
+ * Copyright (C) 2017 Bas Stottelaar <basstottelaar@gmail.com>
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     cpu_efm32_common
+ * @{
+ *
+ * @file
+ * @brief       Implementation of the interrupt handler profiling
+ *
+ * @author      Bas Stottelaar <basstottelaar@gmail.com>
+ *
+ * @}
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "cpu.h"
+#include "irq.h"
+
+#include "cpu_cycles.h"
+#include "isr_profile.h"
+
+#if ISR_PROFILE_ENABLED
+
+static isr_profile_t profiles[EXT_IRQ_COUNT];
+
+void isr_profile_init(void)
+{
+    cpu_cycles_init();
+}
+
+void isr_profile_enter(isr_profile_probe_t *probe)
+{
+    for (unsigned i = 0; i < ISR_PROFILE_WORDS; i++) {
+        probe->pending[i] = NVIC->ISPR[i];
+    }
+
+    probe->start = cpu_cycles_get();
+}
+
+void isr_profile_exit(isr_profile_probe_t *probe, unsigned irq)
+{
+    uint32_t cycles = (cpu_cycles_get() - probe->start) & CPU_CYCLES_MASK;
+
+    /* a handler of a higher priority may preempt this one */
+    unsigned int cpsr = irq_disable();
+
+    isr_profile_t *profile = &profiles[irq];
+
+    profile->count++;
+    profile->total += cycles;
+
+    if (cycles > profile->max) {
+        profile->max = cycles;
+    }
+
+    /* interrupts that were pending during the whole handler waited for it
+       (or for a handler that preempted it) */
+    for (unsigned i = 0; i < ISR_PROFILE_WORDS; i++) {
+        uint32_t waited = probe->pending[i] & NVIC->ISPR[i];
+
+        while (waited) {
+            unsigned other = (i * 32) + __builtin_ctz(waited);
+
+            if (other != irq && cycles > profiles[other].latency) {
+                profiles[other].latency = cycles;
+            }
+
+            waited &= waited - 1;
+        }
+    }
+
+    irq_restore(cpsr);
+}
+
+int isr_profile_get(unsigned irq, isr_profile_t *profile)
+{
+    if (irq >= EXT_IRQ_COUNT) {
+        return -1;
+    }
+
+    unsigned int cpsr = irq_disable();
+
+    *profile = profiles[irq];
+
+    irq_restore(cpsr);
+
+    return 0;
+}
+
+void isr_profile_reset(void)
+{
+    unsigned int cpsr = irq_disable();
+
+    memset(profiles, 0, sizeof(profiles));
+
+    irq_restore(cpsr);
+}
+
+#else
+
+void isr_profile_init(void)
+{
+}
+
+int isr_profile_get(unsigned irq, isr_profile_t *profile)
+{
+    if (irq >= EXT_IRQ_COUNT) {
+        return -1;
+    }
+
+    memset(profile, 0, sizeof(isr_profile_t));
+
+    return 0;
+}
+
+void isr_profile_reset(void)
+{
+}
+
+#endif /* ISR_PROFILE_ENABLED */
+
+int isr_profile_cmd(int argc, char **argv)
+{
+    isr_profile_t profile;
+
+    if (argc > 2 || (argc == 2 && strcmp(argv[1], "reset") != 0)) {
+        printf("usage: %s [reset]\n", argv[0]);
+        return 1;
+    }
+
+    if (!ISR_PROFILE_ENABLED) {
+        puts("interrupt profiling disabled (see ISR_PROFILE_ENABLED)");
+        return 1;
+    }
+
+    if (argc == 2) {
+        isr_profile_reset();
+        return 0;
+    }
+
+    printf("%-3s %-12s %10s %10s %10s %10s\n",
+           "irq", "name", "count", "avg", "max", "latency");
+
+    for (unsigned irq = 0; irq < EXT_IRQ_COUNT; irq++) {
+        isr_profile_get(irq, &profile);
+
+        /* skip the handlers that did not run */
+        if (profile.count == 0) {
+            continue;
+        }
+
+#if ISR_PROFILE_ENABLED
+        const char *name = isr_profile_names[irq];
+#else
+        const char *name = NULL;
+#endif
+
+        printf("%3u %-12s %10lu %10lu %10lu %10lu\n",
+               irq, name ? name : "?",
+               (unsigned long) profile.count,
+               (unsigned long) (profile.total / profile.count),
+               (unsigned long) profile.max,
+               (unsigned long) profile.latency);
+    }
+
+    return 0;
+}
@@ -24,8 +24,11 @@
 #include "periph_conf.h"
 #include "periph/adc.h"
 
+#include "clk.h"
+
 #include "em_cmu.h"
 #include "em_adc.h"
+#include "em_ldma.h"
 #include "em_common_utils.h"
 
 static mutex_t adc_lock[ADC_NUMOF] = {
@@ -37,6 +40,74 @@ static mutex_t adc_lock[ADC_NUMOF] = {
 #endif
 };
 
+typedef struct {
+    bool initialized;               /**< peripheral is initialized */
+    bool configured;                /**< a channel is configured */
+    adc_t line;                     /**< currently configured line */
+    adc_res_t res;                  /**< currently configured resolution */
+} adc_state_t;
+
+typedef struct {
+    bool initialized;               /**< channel is initialized */
+    uint32_t singlectrl;            /**< SINGLECTRL value (without resolution) */
+#ifdef _ADC_SINGLECTRLX_MASK
+    uint32_t singlectrlx;           /**< SINGLECTRLX value */
+#endif
+    uint32_t cal;                   /**< calibration value for reference */
+} adc_channel_state_t;
+
+static adc_state_t adc_state[ADC_NUMOF];
+
+static adc_channel_state_t adc_channel_state[ADC_NUMOF];
+
+#if (defined(DMA_COUNT) && DMA_COUNT > 0) || (defined(LDMA_COUNT) && LDMA_COUNT > 0)
+typedef struct {
+    adc_stream_cb_t cb;             /**< callback for each completed half */
+    void *arg;                      /**< argument passed to the callback */
+    size_t len;                     /**< number of samples per half */
+    uint8_t shift;                  /**< number of shifts per sample */
+} adc_stream_state_t;
+
+static adc_stream_state_t adc_stream_state[ADC_NUMOF];
+#endif
+
+/**
+ * @brief   Write the precomputed channel configuration to the peripheral, if
+ *          it differs from the current configuration.
+ */
+static void _configure(adc_t line, adc_res_t res)
+{
+    uint8_t dev = adc_channel_config[line].dev;
+    ADC_TypeDef *adc = adc_config[dev].dev;
+
+    if (adc_state[dev].configured &&
+        adc_state[dev].line == line &&
+        adc_state[dev].res == res) {
+        return;
+    }
+
+    /* setup oversampling rate, which is shared by all channels */
+    if ((res & 0x0F) == adcResOVS) {
+        adc->CTRL = (adc->CTRL & ~_ADC_CTRL_OVSRSEL_MASK) |
+                    ((res >> 8) << _ADC_CTRL_OVSRSEL_SHIFT);
+    }
+
+    /* reference calibration only changes when the line changes */
+    if (!adc_state[dev].configured || adc_state[dev].line != line) {
+        adc->CAL = adc_channel_state[line].cal;
+#ifdef _ADC_SINGLECTRLX_MASK
+        adc->SINGLECTRLX = adc_channel_state[line].singlectrlx;
+#endif
+    }
+
+    adc->SINGLECTRL = adc_channel_state[line].singlectrl |
+                      ((res & 0x0F) << _ADC_SINGLECTRL_RES_SHIFT);
+
+    adc_state[dev].configured = true;
+    adc_state[dev].line = line;
+    adc_state[dev].res = res;
+}
+
 int adc_init(adc_t line)
 {
     /* check if line is valid */
@@ -44,36 +115,41 @@ int adc_init(adc_t line)
         return -1;
     }
 
+    /* initializing a line twice has no effect */
+    if (adc_channel_state[line].initialized) {
+        return 0;
+    }
+
     uint8_t dev = adc_channel_config[line].dev;
+    ADC_TypeDef *adc = adc_config[dev].dev;
 
-    /* enable clock */
-    CMU_ClockEnable(cmuClock_HFPER, true);
-    CMU_ClockEnable(adc_config[dev].cmu, true);
+    mutex_lock(&adc_lock[dev]);
 
-    /* reset and initialize peripheral */
-    EFM32_CREATE_INIT(init, ADC_Init_TypeDef, ADC_INIT_DEFAULT,
-        .conf.timebase = ADC_TimebaseCalc(0),
-        .conf.prescale = ADC_PrescaleCalc(400000, 0)
-    );
+    /* the ADC prescaler is computed from the HFXO frequency */
+    pm_hfxo_wait();
 
-    ADC_Reset(adc_config[dev].dev);
-    ADC_Init(adc_config[dev].dev, &init.conf);
+    /* the clock is enabled while configuring or sampling only, the
+       configuration is retained in between */
+    clk_acquire(adc_config[dev].cmu);
 
-    return 0;
-}
+    /* reset and initialize peripheral, only once per device */
+    if (!adc_state[dev].initialized) {
+        EFM32_CREATE_INIT(init, ADC_Init_TypeDef, ADC_INIT_DEFAULT,
+            .conf.timebase = ADC_TimebaseCalc(0),
+            .conf.prescale = ADC_PrescaleCalc(400000, 0)
+        );
 
-int adc_sample(adc_t line, adc_res_t res)
-{
-    uint8_t dev = adc_channel_config[line].dev;
+        ADC_Reset(adc);
+        ADC_Init(adc, &init.conf);
 
-    /* lock device */
-    mutex_lock(&adc_lock[dev]);
+        adc_state[dev].initialized = true;
+    }
 
-    /* setup channel */
+    /* let emlib compute the channel configuration once, and store the
+       resulting register values for use by adc_sample */
     EFM32_CREATE_INIT(init, ADC_InitSingle_TypeDef, ADC_INITSINGLE_DEFAULT,
         .conf.acqTime = adc_channel_config[line].acq_time,
         .conf.reference = adc_channel_config[line].reference,
-        .conf.resolution = (ADC_Res_TypeDef) (res & 0xFF),
 #ifdef _SILICON_LABS_32B_PLATFORM_1
         .conf.input = adc_channel_config[line].input,
 #else
@@ -81,7 +157,39 @@ int adc_sample(adc_t line, adc_res_t res)
 #endif
     );
 
-    ADC_InitSingle(adc_config[dev].dev, &init.conf);
+    ADC_InitSingle(adc, &init.conf);
+
+    adc_channel_state[line].singlectrl = adc->SINGLECTRL &
+                                         ~_ADC_SINGLECTRL_RES_MASK;
+#ifdef _ADC_SINGLECTRLX_MASK
+    adc_channel_state[line].singlectrlx = adc->SINGLECTRLX;
+#endif
+    adc_channel_state[line].cal = adc->CAL;
+    adc_channel_state[line].initialized = true;
+
+    /* the active configuration now is of this line */
+    adc_state[dev].configured = true;
+    adc_state[dev].line = line;
+    adc_state[dev].res = ADC_RES_12BIT;
+
+    clk_release(adc_config[dev].cmu);
+
+    mutex_unlock(&adc_lock[dev]);
+
+    return 0;
+}
+
+int adc_sample(adc_t line, adc_res_t res)
+{
+    uint8_t dev = adc_channel_config[line].dev;
+
+    /* lock device */
+    mutex_lock(&adc_lock[dev]);
+
+    clk_acquire(adc_config[dev].cmu);
+
+    /* setup channel (if needed) */
+    _configure(line, res);
 
     /* start conversion and block until it completes */
     ADC_Start(adc_config[dev].dev, adcStartSingle);
@@ -91,11 +199,115 @@ int adc_sample(adc_t line, adc_res_t res)
     int result = ADC_DataSingleGet(adc_config[dev].dev);
 
     /* for resolutions that are not really supported, shift the result (for
-       instance, 10 bit resolution is achieved by shifting a 12 bit sample). */
-    result = result >> (res >> 4);
+       instance, 10 bit resolution is achieved by shifting a 12 bit sample, and
+       13 bit resolution by shifting a 14 bit oversampled result). */
+    result = result >> ((res >> 4) & 0x0F);
+
+    clk_release(adc_config[dev].cmu);
 
     /* unlock device */
     mutex_unlock(&adc_lock[dev]);
 
     return result;
 }
+
+#if (defined(DMA_COUNT) && DMA_COUNT > 0) || (defined(LDMA_COUNT) && LDMA_COUNT > 0)
+/**
+ * @brief   Scale a completed half of samples, and pass it to the user.
+ */
+static void _stream_done(void *arg, void *buf)
+{
+    adc_stream_state_t *state = (adc_stream_state_t *) arg;
+    uint16_t *samples = (uint16_t *) buf;
+
+    if (state->shift > 0) {
+        for (size_t i = 0; i < state->len; i++) {
+            samples[i] >>= state->shift;
+        }
+    }
+
+    state->cb(state->arg, samples, state->len);
+}
+
+int adc_stream(adc_t line, adc_res_t res, const stream_conf_t *conf,
+               uint32_t rate, uint16_t *buf, size_t len,
+               adc_stream_cb_t cb, void *arg)
+{
+    /* check if line is valid and initialized */
+    if (line >= ADC_NUMOF || !adc_channel_state[line].initialized) {
+        return -1;
+    }
+
+    uint8_t dev = adc_channel_config[line].dev;
+    ADC_TypeDef *adc = adc_config[dev].dev;
+
+    /* only ADC0 can request DMA transfers */
+    if (adc != ADC0) {
+        return -1;
+    }
+
+    /* the device is reserved (and clocked) until the stream is stopped */
+    mutex_lock(&adc_lock[dev]);
+
+    clk_acquire(adc_config[dev].cmu);
+
+    _configure(line, res);
+
+    /* trigger conversions by the PRS channel */
+#ifdef _ADC_SINGLECTRLX_PRSSEL_MASK
+    adc->SINGLECTRLX = (adc->SINGLECTRLX & ~_ADC_SINGLECTRLX_PRSSEL_MASK) |
+                       (conf->prs_channel << _ADC_SINGLECTRLX_PRSSEL_SHIFT);
+    adc->SINGLECTRL |= ADC_SINGLECTRL_PRSEN;
+#else
+    adc->SINGLECTRL = (adc->SINGLECTRL & ~_ADC_SINGLECTRL_PRSSEL_MASK) |
+                      ADC_SINGLECTRL_PRSEN |
+                      (conf->prs_channel << _ADC_SINGLECTRL_PRSSEL_SHIFT);
+#endif
+
+    /* configuration differs from the cached one now */
+    adc_state[dev].configured = false;
+
+    adc_stream_state[dev].cb = cb;
+    adc_stream_state[dev].arg = arg;
+    adc_stream_state[dev].len = len;
+    adc_stream_state[dev].shift = (res >> 4) & 0x0F;
+
+#if defined(DMA_COUNT) && DMA_COUNT > 0
+    uint32_t signal = DMAREQ_ADC0_SINGLE;
+#else
+    uint32_t signal = ldmaPeripheralSignal_ADC0_SINGLE;
+#endif
+
+    if (dma_stream(conf->dma_channel, DMA_PERIPH_TO_MEM, signal,
+                   (volatile void *) &adc->SINGLEDATA, buf, len,
+                   DMA_WIDTH_HALFWORD, _stream_done, &adc_stream_state[dev]) != 0) {
+        clk_release(adc_config[dev].cmu);
+        mutex_unlock(&adc_lock[dev]);
+        return -1;
+    }
+
+    if (stream_timer_start(conf, rate) != 0) {
+        dma_stop(conf->dma_channel);
+        clk_release(adc_config[dev].cmu);
+        mutex_unlock(&adc_lock[dev]);
+        return -1;
+    }
+
+    return 0;
+}
+
+void adc_stream_stop(adc_t line, const stream_conf_t *conf)
+{
+    uint8_t dev = adc_channel_config[line].dev;
+
+    stream_timer_stop(conf);
+    dma_stop(conf->dma_channel);
+
+    /* restore software triggered conversions */
+    adc_config[dev].dev->SINGLECTRL &= ~ADC_SINGLECTRL_PRSEN;
+
+    clk_release(adc_config[dev].cmu);
+
+    mutex_unlock(&adc_lock[dev]);
+}
+#endif
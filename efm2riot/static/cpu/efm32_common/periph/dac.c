@@ -23,6 +23,8 @@
 #include "periph_conf.h"
 #include "periph/dac.h"
 
+#include "clk.h"
+
 #include "em_cmu.h"
 #if defined(DAC_COUNT) && DAC_COUNT > 0
 #include "em_dac.h"
@@ -31,6 +33,41 @@
 
 #if defined(DAC_COUNT) && DAC_COUNT > 0
 
+typedef struct {
+    dac_stream_cb_t cb;             /**< callback for each completed half */
+    void *arg;                      /**< argument passed to the callback */
+    size_t len;                     /**< number of samples per half */
+} dac_stream_state_t;
+
+static dac_stream_state_t dac_stream_state[DAC_NUMOF];
+
+/**
+ * @brief   Track if a line holds the clock of its device, while it is powered
+ */
+static bool dac_powered[DAC_NUMOF];
+
+/**
+ * @brief   Acquire (or release) the clock of the device of a line, while the
+ *          line is powered.
+ */
+static void _powered(dac_t line, bool powered)
+{
+    uint8_t dev = dac_channel_config[line].dev;
+
+    if (dac_powered[line] == powered) {
+        return;
+    }
+
+    if (powered) {
+        clk_acquire(dac_config[dev].cmu);
+    }
+    else {
+        clk_release(dac_config[dev].cmu);
+    }
+
+    dac_powered[line] = powered;
+}
+
 int8_t dac_init(dac_t line)
 {
     /* check if device is valid */
@@ -41,8 +78,7 @@ int8_t dac_init(dac_t line)
     uint8_t dev = dac_channel_config[line].dev;
 
     /* enable clock */
-    CMU_ClockEnable(cmuClock_HFPER, true);
-    CMU_ClockEnable(dac_config[dev].cmu, true);
+    _powered(line, true);
 
     /* reset and initialize peripheral */
     DAC_Init_TypeDef init = DAC_INIT_DEFAULT;
@@ -73,16 +109,89 @@ void dac_set(dac_t line, uint16_t value)
 
 void dac_poweron(dac_t line)
 {
+    _powered(line, true);
+}
+
+void dac_poweroff(dac_t line)
+{
+    _powered(line, false);
+}
+
+/**
+ * @brief   Pass a completed half to the user, so it can be refilled.
+ */
+static void _stream_done(void *arg, void *buf)
+{
+    dac_stream_state_t *state = (dac_stream_state_t *) arg;
+
+    if (state->cb != NULL) {
+        state->cb(state->arg, (uint16_t *) buf, state->len);
+    }
+}
+
+int dac_stream(dac_t line, const stream_conf_t *conf, uint32_t rate,
+               uint16_t *buf, size_t len, dac_stream_cb_t cb, void *arg)
+{
+    /* check if device is valid */
+    if (line >= DAC_NUMOF) {
+        return -1;
+    }
+
     uint8_t dev = dac_channel_config[line].dev;
+    uint8_t index = dac_channel_config[line].index;
+    DAC_TypeDef *dac = dac_config[dev].dev;
 
-    CMU_ClockEnable(dac_config[dev].cmu, true);
+    /* only DAC0 can request DMA transfers */
+    if (dac != DAC0) {
+        return -1;
+    }
+
+    /* hold each sample until the PRS channel triggers the conversion (both
+       channel control registers share the same layout) */
+    volatile uint32_t *ctrl = index ? &dac->CH1CTRL : &dac->CH0CTRL;
+
+    *ctrl = (*ctrl & ~_DAC_CH0CTRL_PRSSEL_MASK) |
+            DAC_CH0CTRL_PRSEN |
+            (conf->prs_channel << _DAC_CH0CTRL_PRSSEL_SHIFT);
+
+    dac_stream_state[line].cb = cb;
+    dac_stream_state[line].arg = arg;
+    dac_stream_state[line].len = len;
+
+    /* a new sample is requested when the previous one is converted */
+    if (dma_stream(conf->dma_channel, DMA_MEM_TO_PERIPH,
+                   index ? DMAREQ_DAC0_CH1 : DMAREQ_DAC0_CH0,
+                   index ? &dac->CH1DATA : &dac->CH0DATA,
+                   buf, len, DMA_WIDTH_HALFWORD,
+                   _stream_done, &dac_stream_state[line]) != 0) {
+        *ctrl &= ~DAC_CH0CTRL_PRSEN;
+        return -1;
+    }
+
+    if (stream_timer_start(conf, rate) != 0) {
+        dma_stop(conf->dma_channel);
+        *ctrl &= ~DAC_CH0CTRL_PRSEN;
+        return -1;
+    }
+
+    return 0;
 }
 
-void dac_poweroff(dac_t line)
+void dac_stream_stop(dac_t line, const stream_conf_t *conf)
 {
     uint8_t dev = dac_channel_config[line].dev;
+    DAC_TypeDef *dac = dac_config[dev].dev;
 
-    CMU_ClockEnable(dac_config[dev].cmu, false);
+    stream_timer_stop(conf);
+    dma_stop(conf->dma_channel);
+
+    /* restore immediate conversions for dac_set */
+    if (dac_channel_config[line].index) {
+        dac->CH1CTRL &= ~DAC_CH1CTRL_PRSEN;
+    }
+    else {
+        dac->CH0CTRL &= ~DAC_CH0CTRL_PRSEN;
+    }
 }
 
 #endif /* defined(DAC_COUNT) && DAC_COUNT > 0 */
@@ -0,0 +1,335 @@
+/*
+ * Copyright (C) 2017 Bas Stottelaar <basstottelaar@gmail.com>
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     cpu_efm32_common
+ * @{
+ *
+ * @file
+ * @brief       Low-level DAC driver implementation for EFM32 Gemstone MCUs
+ *              (using the VDAC)
+ *
+ * @author      Bas Stottelaar <basstottelaar@gmail.com>
+ *
+ * @}
+ */
+
+#include "cpu.h"
+
+#include "periph_conf.h"
+#include "periph/dac.h"
+
+#include "clk.h"
+
+#include "em_cmu.h"
+
+#if defined(VDAC_COUNT) && VDAC_COUNT > 0
+
+/**
+ * @brief   Maximum VDAC clock frequency (see reference manual).
+ */
+#define VDAC_MAX_FREQ       (1000000U)
+
+/**
+ * @brief   Frequency of the internal VDAC oscillator, used in asynchronous
+ *          (low-power) clock mode.
+ */
+#define VDAC_ASYNC_FREQ     (12000000U)
+
+typedef struct {
+    dac_stream_cb_t cb;             /**< callback for each completed half */
+    void *arg;                      /**< argument passed to the callback */
+    size_t len;                     /**< number of samples per half */
+} dac_stream_state_t;
+
+static bool dac_initialized[VDAC_COUNT];
+
+static dac_stream_state_t dac_stream_state[DAC_NUMOF];
+
+/**
+ * @brief   Track if a line holds the clock of its device, while it is powered
+ */
+static bool dac_powered[DAC_NUMOF];
+
+/**
+ * @brief   Acquire (or release) the clock of the device of a line, while the
+ *          line is powered.
+ */
+static void _powered(dac_t line, bool powered)
+{
+    uint8_t dev = dac_channel_config[line].dev;
+
+    if (dac_powered[line] == powered) {
+        return;
+    }
+
+    if (powered) {
+        clk_acquire(dac_config[dev].cmu);
+    }
+    else {
+        clk_release(dac_config[dev].cmu);
+    }
+
+    dac_powered[line] = powered;
+}
+
+/**
+ * @brief   Compute the calibration register value for a reference, from the
+ *          factory calibration in the device information page.
+ */
+static uint32_t _calibration(uint32_t ref)
+{
+    uint32_t main = DEVINFO->VDAC0MAINCAL;
+    uint32_t ch1 = DEVINFO->VDAC0CH1CAL;
+    uint32_t gain, gain_ch1;
+
+    switch (ref) {
+        case VDAC_CTRL_REFSEL_1V25LN:
+            gain = (main & _DEVINFO_VDAC0MAINCAL_GAINERRTRIM1V25LN_MASK) >>
+                   _DEVINFO_VDAC0MAINCAL_GAINERRTRIM1V25LN_SHIFT;
+            break;
+        case VDAC_CTRL_REFSEL_2V5LN:
+            gain = (main & _DEVINFO_VDAC0MAINCAL_GAINERRTRIM2V5LN_MASK) >>
+                   _DEVINFO_VDAC0MAINCAL_GAINERRTRIM2V5LN_SHIFT;
+            break;
+        case VDAC_CTRL_REFSEL_1V25:
+            gain = (main & _DEVINFO_VDAC0MAINCAL_GAINERRTRIM1V25_MASK) >>
+                   _DEVINFO_VDAC0MAINCAL_GAINERRTRIM1V25_SHIFT;
+            break;
+        case VDAC_CTRL_REFSEL_2V5:
+            gain = (main & _DEVINFO_VDAC0MAINCAL_GAINERRTRIM2V5_MASK) >>
+                   _DEVINFO_VDAC0MAINCAL_GAINERRTRIM2V5_SHIFT;
+            break;
+        default:
+            gain = (main & _DEVINFO_VDAC0MAINCAL_GAINERRTRIMVDDANAEXTPIN_MASK) >>
+                   _DEVINFO_VDAC0MAINCAL_GAINERRTRIMVDDANAEXTPIN_SHIFT;
+            break;
+    }
+
+    /* channel 1 has a separate gain trim for the 2.5 V references */
+    if (ref == VDAC_CTRL_REFSEL_2V5LN || ref == VDAC_CTRL_REFSEL_2V5) {
+        gain_ch1 = (ch1 & _DEVINFO_VDAC0CH1CAL_GAINERRTRIMCH1B_MASK) >>
+                   _DEVINFO_VDAC0CH1CAL_GAINERRTRIMCH1B_SHIFT;
+    }
+    else {
+        gain_ch1 = (ch1 & _DEVINFO_VDAC0CH1CAL_GAINERRTRIMCH1A_MASK) >>
+                   _DEVINFO_VDAC0CH1CAL_GAINERRTRIMCH1A_SHIFT;
+    }
+
+    return (((ch1 & _DEVINFO_VDAC0CH1CAL_OFFSETTRIM_MASK) >>
+             _DEVINFO_VDAC0CH1CAL_OFFSETTRIM_SHIFT) << _VDAC_CAL_OFFSETTRIM_SHIFT) |
+           (gain << _VDAC_CAL_GAINERRTRIM_SHIFT) |
+           (gain_ch1 << _VDAC_CAL_GAINERRTRIMCH1_SHIFT);
+}
+
+/**
+ * @brief   Compute the prescaler for the VDAC clock, which is either the
+ *          internal oscillator (asynchronous) or the HFPERCLK.
+ */
+static uint32_t _prescaler(bool async)
+{
+    uint32_t freq = async ? VDAC_ASYNC_FREQ : CMU_ClockFreqGet(cmuClock_HFPER);
+    uint32_t prescaler = (freq + VDAC_MAX_FREQ - 1) / VDAC_MAX_FREQ;
+
+    if (prescaler > 0) {
+        prescaler--;
+    }
+
+    if (prescaler > (_VDAC_CTRL_PRESC_MASK >> _VDAC_CTRL_PRESC_SHIFT)) {
+        prescaler = (_VDAC_CTRL_PRESC_MASK >> _VDAC_CTRL_PRESC_SHIFT);
+    }
+
+    return prescaler << _VDAC_CTRL_PRESC_SHIFT;
+}
+
+/**
+ * @brief   Enable (or disable) a channel, and wait until it has settled.
+ */
+static void _enable_channel(VDAC_TypeDef *vdac, uint8_t index, bool enable)
+{
+    uint32_t status = index ? VDAC_STATUS_CH1ENS : VDAC_STATUS_CH0ENS;
+
+    if (enable) {
+        vdac->CMD = index ? VDAC_CMD_CH1EN : VDAC_CMD_CH0EN;
+        while (!(vdac->STATUS & status)) {}
+    }
+    else {
+        vdac->CMD = index ? VDAC_CMD_CH1DIS : VDAC_CMD_CH0DIS;
+        while (vdac->STATUS & status) {}
+    }
+}
+
+/**
+ * @brief   Initialize a channel, triggered by software or by a PRS channel.
+ *
+ * In low-power mode, the channel is sampled-off and refreshed periodically,
+ * so the output is retained in EM2/EM3.
+ */
+static void _init_channel(dac_t line, bool prs, uint8_t prs_channel)
+{
+    uint8_t dev = dac_channel_config[line].dev;
+    uint8_t index = dac_channel_config[line].index;
+    VDAC_TypeDef *vdac = dac_config[dev].dev;
+    bool low_power = dac_config[dev].low_power;
+
+    /* CH0CTRL and CH1CTRL share the same layout */
+    uint32_t ctrl = (prs_channel << _VDAC_CH0CTRL_PRSSEL_SHIFT);
+
+    if (prs) {
+        ctrl |= VDAC_CH0CTRL_TRIGMODE_PRS;
+    }
+    else if (low_power) {
+        ctrl |= VDAC_CH0CTRL_TRIGMODE_SWREFRESH;
+    }
+    else {
+        ctrl |= VDAC_CH0CTRL_TRIGMODE_SW;
+    }
+
+    if (low_power) {
+        ctrl |= VDAC_CH0CTRL_PRSASYNC | VDAC_CH0CTRL_CONVMODE_SAMPLEOFF;
+    }
+
+    _enable_channel(vdac, index, false);
+
+    if (index) {
+        vdac->CH1CTRL = ctrl;
+    }
+    else {
+        vdac->CH0CTRL = ctrl;
+    }
+
+    _enable_channel(vdac, index, true);
+}
+
+int8_t dac_init(dac_t line)
+{
+    /* check if device is valid */
+    if (line >= DAC_NUMOF) {
+        return -1;
+    }
+
+    uint8_t dev = dac_channel_config[line].dev;
+
+    /* enable clock */
+    _powered(line, true);
+
+    /* reset and initialize peripheral, only once per device, since all
+       channels share the reference */
+    if (!dac_initialized[dev]) {
+        VDAC_TypeDef *vdac = dac_config[dev].dev;
+        bool low_power = dac_config[dev].low_power;
+
+        _enable_channel(vdac, 0, false);
+        _enable_channel(vdac, 1, false);
+
+        vdac->CTRL = (low_power ? VDAC_CTRL_DACCLKMODE_ASYNC :
+                                  VDAC_CTRL_DACCLKMODE_SYNC) |
+                     VDAC_CTRL_REFRESHPERIOD_8CYCLES |
+                     _prescaler(low_power) |
+                     dac_config[dev].ref;
+        vdac->CAL = _calibration(dac_config[dev].ref);
+
+        dac_initialized[dev] = true;
+    }
+
+    /* initialize channel */
+    _init_channel(line, false, 0);
+
+    return 0;
+}
+
+void dac_set(dac_t line, uint16_t value)
+{
+    uint8_t dev = dac_channel_config[line].dev;
+    VDAC_TypeDef *vdac = dac_config[dev].dev;
+
+    if (dac_channel_config[line].index) {
+        vdac->CH1DATA = value & 0xfff;
+    }
+    else {
+        vdac->CH0DATA = value & 0xfff;
+    }
+}
+
+void dac_poweron(dac_t line)
+{
+    _powered(line, true);
+}
+
+void dac_poweroff(dac_t line)
+{
+    _powered(line, false);
+}
+
+/**
+ * @brief   Pass a completed half to the user, so it can be refilled.
+ */
+static void _stream_done(void *arg, void *buf)
+{
+    dac_stream_state_t *state = (dac_stream_state_t *) arg;
+
+    if (state->cb != NULL) {
+        state->cb(state->arg, (uint16_t *) buf, state->len);
+    }
+}
+
+int dac_stream(dac_t line, const stream_conf_t *conf, uint32_t rate,
+               uint16_t *buf, size_t len, dac_stream_cb_t cb, void *arg)
+{
+    /* check if device is valid */
+    if (line >= DAC_NUMOF) {
+        return -1;
+    }
+
+    uint8_t dev = dac_channel_config[line].dev;
+    uint8_t index = dac_channel_config[line].index;
+    VDAC_TypeDef *vdac = dac_config[dev].dev;
+
+    /* only VDAC0 can request DMA transfers */
+    if (vdac != VDAC0) {
+        return -1;
+    }
+
+    /* hold each sample until the PRS channel triggers the conversion */
+    _init_channel(line, true, conf->prs_channel);
+
+    dac_stream_state[line].cb = cb;
+    dac_stream_state[line].arg = arg;
+    dac_stream_state[line].len = len;
+
+    /* a new sample is requested when the previous one is converted */
+    if (dma_stream(conf->dma_channel, DMA_MEM_TO_PERIPH,
+                   LDMA_CH_REQSEL_SOURCESEL_VDAC0 |
+                   (index ? LDMA_CH_REQSEL_SIGSEL_VDAC0CH1 :
+                            LDMA_CH_REQSEL_SIGSEL_VDAC0CH0),
+                   index ? &vdac->CH1DATA : &vdac->CH0DATA,
+                   buf, len, DMA_WIDTH_HALFWORD,
+                   _stream_done, &dac_stream_state[line]) != 0) {
+        _init_channel(line, false, 0);
+        return -1;
+    }
+
+    if (stream_timer_start(conf, rate) != 0) {
+        dma_stop(conf->dma_channel);
+        _init_channel(line, false, 0);
+        return -1;
+    }
+
+    return 0;
+}
+
+void dac_stream_stop(dac_t line, const stream_conf_t *conf)
+{
+    stream_timer_stop(conf);
+    dma_stop(conf->dma_channel);
+
+    /* restore software triggered conversions for dac_set */
+    _init_channel(line, false, 0);
+}
+
+#endif /* defined(VDAC_COUNT) && VDAC_COUNT > 0 */
@@ -0,0 +1,262 @@
+/*
+ * Copyright (C) 2017 Bas Stottelaar <basstottelaar@gmail.com>
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     cpu_efm32_common
+ * @{
+ *
+ * @file
+ * @brief       Low-level DMA driver implementation (for streaming peripheral
+ *              data using a double buffer)
+ *
+ * @author      Bas Stottelaar <basstottelaar@gmail.com>
+ *
+ * @}
+ */
+
+#include "cpu.h"
+
+#include "periph_conf.h"
+
+#include "em_cmu.h"
+#if defined(DMA_COUNT) && DMA_COUNT > 0
+#include "em_dma.h"
+#elif defined(LDMA_COUNT) && LDMA_COUNT > 0
+#include "em_ldma.h"
+#endif
+
+#if (defined(DMA_COUNT) && DMA_COUNT > 0) || (defined(LDMA_COUNT) && LDMA_COUNT > 0)
+
+typedef struct {
+    dma_cb_t cb;                    /**< callback called when a half completes */
+    void *arg;                      /**< argument passed to the callback */
+    uint8_t *buf;                   /**< start of the double buffer */
+    size_t size;                    /**< size of one half (in bytes) */
+    size_t len;                     /**< number of transfers per half */
+#if defined(DMA_COUNT) && DMA_COUNT > 0
+    DMA_CB_TypeDef dma_cb;          /**< emlib callback structure */
+#else
+    uint8_t half;                   /**< index of half being transferred */
+#endif
+} dma_state_t;
+
+static dma_state_t dma_state[DMA_CHAN_COUNT];
+
+static bool dma_initialized = false;
+
+#if defined(DMA_COUNT) && DMA_COUNT > 0
+/**
+ * @brief   Alignment of the DMA control block, which depends on the number of
+ *          channels (see reference manual).
+ */
+#if DMA_CHAN_COUNT <= 4
+#define DMA_CONTROL_BLOCK_ALIGN     (128)
+#else
+#define DMA_CONTROL_BLOCK_ALIGN     (256)
+#endif
+
+/**
+ * @brief   Primary and alternate descriptors of all channels.
+ */
+static DMA_DESCRIPTOR_TypeDef dma_control_block[
+    (DMA_CONTROL_BLOCK_ALIGN * 2) / sizeof(DMA_DESCRIPTOR_TypeDef)]
+    __attribute__((aligned(DMA_CONTROL_BLOCK_ALIGN)));
+
+/**
+ * @brief   Ping-pong completion handler, called by emlib's DMA IRQ handler.
+ */
+static void _done(unsigned int channel, bool primary, void *user)
+{
+    dma_state_t *state = (dma_state_t *) user;
+
+    /* re-arm the completed descriptor, so the transfer continues with this
+       half once the other half completes */
+    DMA_RefreshPingPong(channel, primary, false, NULL, NULL,
+                        state->len - 1, false);
+
+    if (state->cb != NULL) {
+        state->cb(state->arg, state->buf + (primary ? 0 : state->size));
+    }
+}
+#else
+/**
+ * @brief   Linked descriptors for each half of all channels.
+ */
+static LDMA_Descriptor_t dma_descriptors[DMA_CHAN_COUNT][2];
+#endif
+
+/**
+ * @brief   Initialize the DMA controller, once.
+ */
+static void _init(void)
+{
+    if (dma_initialized) {
+        return;
+    }
+
+#if defined(DMA_COUNT) && DMA_COUNT > 0
+    DMA_Init_TypeDef init = {
+        .hprot = 0,
+        .controlBlock = dma_control_block
+    };
+
+    DMA_Init(&init);
+#else
+    LDMA_Init_t init = LDMA_INIT_DEFAULT;
+
+    LDMA_Init(&init);
+#endif
+
+    dma_initialized = true;
+}
+
+int dma_stream(uint8_t channel, dma_dir_t dir, uint32_t signal,
+               volatile void *periph, void *buf, size_t len, dma_width_t width,
+               dma_cb_t cb, void *arg)
+{
+    /* check if channel and length are valid */
+    if (channel >= DMA_CHAN_COUNT || len == 0 || len > DMA_STREAM_MAX_LEN) {
+        return -1;
+    }
+
+    _init();
+
+    dma_state_t *state = &dma_state[channel];
+    uint8_t *first = (uint8_t *) buf;
+    uint8_t *second = first + (len << width);
+
+    state->cb = cb;
+    state->arg = arg;
+    state->buf = first;
+    state->size = (len << width);
+    state->len = len;
+
+#if defined(DMA_COUNT) && DMA_COUNT > 0
+    state->dma_cb.cbFunc = _done;
+    state->dma_cb.userPtr = state;
+    state->dma_cb.primary = true;
+
+    /* configure the channel */
+    DMA_CfgChannel_TypeDef init_channel = {
+        .highPri = false,
+        .enableInt = true,
+        .select = signal,
+        .cb = &state->dma_cb
+    };
+
+    DMA_CfgChannel(channel, &init_channel);
+
+    /* configure primary and alternate descriptors (identical) */
+    DMA_CfgDescr_TypeDef init_descr = {
+        .dstInc = (dir == DMA_PERIPH_TO_MEM) ?
+            (DMA_DataInc_TypeDef) width : dmaDataIncNone,
+        .srcInc = (dir == DMA_PERIPH_TO_MEM) ?
+            dmaDataIncNone : (DMA_DataInc_TypeDef) width,
+        .size = (DMA_DataSize_TypeDef) width,
+        .arbRate = dmaArbitrate1,
+        .hprot = 0
+    };
+
+    DMA_CfgDescr(channel, true, &init_descr);
+    DMA_CfgDescr(channel, false, &init_descr);
+
+    /* start the ping-pong cycle */
+    if (dir == DMA_PERIPH_TO_MEM) {
+        DMA_ActivatePingPong(channel, false,
+                             first, (void *) periph, len - 1,
+                             second, (void *) periph, len - 1);
+    }
+    else {
+        DMA_ActivatePingPong(channel, false,
+                             (void *) periph, first, len - 1,
+                             (void *) periph, second, len - 1);
+    }
+#else
+    state->half = 0;
+
+    /* two descriptors that link to each other, and signal completion */
+    LDMA_Descriptor_t *descriptors = dma_descriptors[channel];
+
+    if (dir == DMA_PERIPH_TO_MEM) {
+        LDMA_Descriptor_t descr[] = {
+            LDMA_DESCRIPTOR_LINKREL_P2M_BYTE(periph, first, len, 1),
+            LDMA_DESCRIPTOR_LINKREL_P2M_BYTE(periph, second, len, -1)
+        };
+
+        descriptors[0] = descr[0];
+        descriptors[1] = descr[1];
+    }
+    else {
+        LDMA_Descriptor_t descr[] = {
+            LDMA_DESCRIPTOR_LINKREL_M2P_BYTE(first, periph, len, 1),
+            LDMA_DESCRIPTOR_LINKREL_M2P_BYTE(second, periph, len, -1)
+        };
+
+        descriptors[0] = descr[0];
+        descriptors[1] = descr[1];
+    }
+
+    /* the descriptor macros assume bytes, but increment by one unit */
+    descriptors[0].xfer.size = (LDMA_CtrlSize_t) width;
+    descriptors[1].xfer.size = (LDMA_CtrlSize_t) width;
+
+    /* start the transfer */
+    LDMA_TransferCfg_t init_transfer = LDMA_TRANSFER_CFG_PERIPHERAL(signal);
+
+    LDMA_StartTransfer(channel, &init_transfer, &descriptors[0]);
+#endif
+
+    return 0;
+}
+
+void dma_stop(uint8_t channel)
+{
+    assert(channel < DMA_CHAN_COUNT);
+
+#if defined(DMA_COUNT) && DMA_COUNT > 0
+    DMA_ChannelEnable(channel, false);
+#else
+    LDMA_StopTransfer(channel);
+#endif
+
+    dma_state[channel].cb = NULL;
+    dma_state[channel].arg = NULL;
+}
+
+#if defined(DMA_COUNT) && DMA_COUNT > 0
+void isr_dma(void)
+{
+    /* emlib takes care of the ping-pong administration */
+    DMA_IRQHandler();
+    cortexm_isr_end();
+}
+#else
+void isr_ldma(void)
+{
+    uint32_t pending = LDMA_IntGetEnabled();
+
+    for (int i = 0; i < DMA_CHAN_COUNT; i++) {
+        if (pending & (1 << i)) {
+            dma_state_t *state = &dma_state[i];
+            uint8_t half = state->half;
+
+            LDMA_IntClear(1 << i);
+
+            /* the other half is being transferred now */
+            state->half ^= 1;
+
+            if (state->cb != NULL) {
+                state->cb(state->arg, state->buf + (half * state->size));
+            }
+        }
+    }
+    cortexm_isr_end();
+}
+#endif
+
+#endif /* (defined(DMA_COUNT) && DMA_COUNT > 0) || (defined(LDMA_COUNT) && LDMA_COUNT > 0) */
@@ -24,6 +24,8 @@
 
 #include "periph/gpio.h"
 
+#include "clk.h"
+
 #include "em_gpio.h"
 
 /**
@@ -36,6 +38,75 @@
  */
 static gpio_isr_ctx_t isr_ctx[NUMOF_IRQS];
 
+/**
+ * @brief   Acquire the GPIO clock, once.
+ *
+ * The GPIO registers are accessed at any time, so the clock is never
+ * released. On Series 0 MCUs, this keeps the HFPER branch enabled as well.
+ */
+static void _clk_acquire(void)
+{
+    static bool acquired;
+
+    if (!acquired) {
+        clk_acquire(cmuClock_GPIO);
+        acquired = true;
+    }
+}
+
+#if defined(_GPIO_EM4WUEN_MASK)
+/**
+ * @brief   Pins that can wake up the MCU from EM4, and their EM4WUEN bit.
+ */
+static const struct {
+    gpio_t pin;             /**< pin that can wake up the MCU */
+    uint32_t mask;          /**< bit in EM4WUEN and EM4WUPOL/EXTILEVEL */
+} em4_wakeup_pins[] = {
+#ifdef _SILICON_LABS_32B_PLATFORM_2
+#ifdef GPIO_EXTILEVEL_EM4WU0
+    { GPIO_PIN(PF, 2), GPIO_EXTILEVEL_EM4WU0 },
+#endif
+#ifdef GPIO_EXTILEVEL_EM4WU1
+    { GPIO_PIN(PF, 7), GPIO_EXTILEVEL_EM4WU1 },
+#endif
+#ifdef GPIO_EXTILEVEL_EM4WU4
+    { GPIO_PIN(PD, 14), GPIO_EXTILEVEL_EM4WU4 },
+#endif
+#ifdef GPIO_EXTILEVEL_EM4WU8
+    { GPIO_PIN(PA, 3), GPIO_EXTILEVEL_EM4WU8 },
+#endif
+#ifdef GPIO_EXTILEVEL_EM4WU9
+    { GPIO_PIN(PB, 13), GPIO_EXTILEVEL_EM4WU9 },
+#endif
+#ifdef GPIO_EXTILEVEL_EM4WU12
+    { GPIO_PIN(PC, 10), GPIO_EXTILEVEL_EM4WU12 },
+#endif
+#else
+#ifdef GPIO_EM4WUEN_EM4WUEN_A0
+    { GPIO_PIN(PA, 0), GPIO_EM4WUEN_EM4WUEN_A0 },
+#endif
+#ifdef GPIO_EM4WUEN_EM4WUEN_A6
+    { GPIO_PIN(PA, 6), GPIO_EM4WUEN_EM4WUEN_A6 },
+#endif
+#ifdef GPIO_EM4WUEN_EM4WUEN_C4
+    { GPIO_PIN(PC, 4), GPIO_EM4WUEN_EM4WUEN_C4 },
+#endif
+#ifdef GPIO_EM4WUEN_EM4WUEN_C9
+    { GPIO_PIN(PC, 9), GPIO_EM4WUEN_EM4WUEN_C9 },
+#endif
+#ifdef GPIO_EM4WUEN_EM4WUEN_E13
+    { GPIO_PIN(PE, 13), GPIO_EM4WUEN_EM4WUEN_E13 },
+#endif
+#ifdef GPIO_EM4WUEN_EM4WUEN_F1
+    { GPIO_PIN(PF, 1), GPIO_EM4WUEN_EM4WUEN_F1 },
+#endif
+#ifdef GPIO_EM4WUEN_EM4WUEN_F2
+    { GPIO_PIN(PF, 2), GPIO_EM4WUEN_EM4WUEN_F2 },
+#endif
+#endif
+};
+#endif
+
 static inline GPIO_Port_TypeDef _port_num(gpio_t pin)
 {
     return ((pin & 0xf0) >> 4);
@@ -51,6 +122,27 @@ static inline uint32_t _pin_mask(gpio_t pin)
     return (1 << _pin_num(pin));
 }
 
+/**
+ * @brief   Get the EM4WUEN bit of a pin, or zero if it cannot wake up the
+ *          MCU from EM4.
+ */
+static uint32_t _em4_wakeup_mask(gpio_t pin)
+{
+#if defined(_GPIO_EM4WUEN_MASK)
+    unsigned numof = sizeof(em4_wakeup_pins) / sizeof(em4_wakeup_pins[0]);
+
+    for (unsigned i = 0; i < numof; i++) {
+        if (em4_wakeup_pins[i].pin == pin) {
+            return em4_wakeup_pins[i].mask;
+        }
+    }
+#else
+    (void) pin;
+#endif
+
+    return 0;
+}
+
 int gpio_init(gpio_t pin, gpio_mode_t mode)
 {
     /* check for valid pin */
@@ -59,8 +151,7 @@ int gpio_init(gpio_t pin, gpio_mode_t mode)
     }
 
     /* enable clocks */
-    CMU_ClockEnable(cmuClock_HFPER, true);
-    CMU_ClockEnable(cmuClock_GPIO, true);
+    _clk_acquire();
 
     /* configure pin */
     GPIO_PinModeSet(_port_num(pin), _pin_num(pin), mode >> 1, mode & 0x1);
@@ -100,6 +191,56 @@ int gpio_init_int(gpio_t pin, gpio_mode_t mode, gpio_flank_t flank,
     return 0;
 }
 
+int gpio_init_em4_wakeup(gpio_t pin, gpio_mode_t mode, int level)
+{
+    uint32_t mask = _em4_wakeup_mask(pin);
+
+    if (mask == 0) {
+        return -1;
+    }
+
+    int result = gpio_init(pin, mode);
+
+    if (result != 0) {
+        return result;
+    }
+
+#if defined(_GPIO_EM4WUEN_MASK)
+    /* this also enables pin retention, and clears the wake-up logic */
+    GPIO_EM4EnablePinWakeup(mask, level ? mask : 0);
+#endif
+
+    return 0;
+}
+
+void gpio_em4_wakeup_disable(gpio_t pin)
+{
+#if defined(_GPIO_EM4WUEN_MASK)
+    uint32_t mask = _em4_wakeup_mask(pin);
+
+    if (mask != 0) {
+        _clk_acquire();
+        GPIO_EM4DisablePinWakeup(mask);
+    }
+#else
+    (void) pin;
+#endif
+}
+
+bool gpio_em4_wakeup_cause(gpio_t pin)
+{
+#if defined(_GPIO_EM4WUCAUSE_MASK) || defined(_GPIO_IF_EM4WU_MASK)
+    /* the cause may be checked before any pin is initialized */
+    _clk_acquire();
+
+    return (GPIO_EM4GetPinWakeupCause() & _em4_wakeup_mask(pin)) != 0;
+#else
+    (void) pin;
+
+    return false;
+#endif
+}
+
 void gpio_irq_enable(gpio_t pin)
 {
     GPIO_IntEnable(_pin_mask(pin));
@@ -143,7 +284,7 @@ void gpio_write(gpio_t pin, int value)
 /**
  * @brief   Actual interrupt handler for both even and odd pin index numbers.
  */
-static void gpio_irq(void)
+static EFM32_RAMFUNC void gpio_irq(void)
 {
     for (int i = 0; i < NUMOF_IRQS; i++) {
         if (GPIO_IntGet() & (1 << i)) {
@@ -157,7 +298,7 @@ static void gpio_irq(void)
 /**
  * @brief   External interrupt handler for even pin index numbers
  */
-void isr_gpio_even(void)
+EFM32_RAMFUNC void isr_gpio_even(void)
 {
     gpio_irq();
 }
@@ -165,7 +306,7 @@ void isr_gpio_even(void)
 /**
  * @brief   External interrupt handler for odd pin index numbers
  */
-void isr_gpio_odd(void)
+EFM32_RAMFUNC void isr_gpio_odd(void)
 {
     gpio_irq();
 }
@@ -27,6 +27,8 @@
 #include "periph_conf.h"
 #include "periph/hwcrypto.h"
 
+#include "clk.h"
+
 #include "em_cmu.h"
 #include "em_aes.h"
 
@@ -58,10 +60,8 @@ static void hwcrypto_cipher_increment(uint8_t* ctr)
 
 int hwcrypto_init(void)
 {
-    /* enable clocks */
-    CMU_ClockEnable(cmuClock_HFPER, true);
-    CMU_ClockEnable(cmuClock_AES, true);
-
+    /* the clock is enabled while the hardware is acquired only (see
+       hwcrypto_acquire) */
     return 0;
 }
 
@@ -239,11 +239,15 @@ int hwcrypto_acquire(void)
 {
     mutex_lock((mutex_t *) &hwcrypto_lock);
 
+    clk_acquire(cmuClock_AES);
+
     return 0;
 }
 
 int hwcrypto_release(void)
 {
+    clk_release(cmuClock_AES);
+
     mutex_unlock((mutex_t *) &hwcrypto_lock);
 
     return 0;
@@ -251,12 +255,12 @@ int hwcrypto_release(void)
 
 void hwcrypto_poweron(void)
 {
-    CMU_ClockEnable(cmuClock_AES, true);
+    /* the clock is enabled while the hardware is acquired only */
 }
 
 void hwcrypto_poweroff(void)
 {
-    CMU_ClockEnable(cmuClock_AES, false);
+    /* the clock is gated when the hardware is released */
 }
 
 #endif /* _SILICON_LABS_32B_PLATFORM_1 */
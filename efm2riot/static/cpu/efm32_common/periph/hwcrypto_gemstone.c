@@ -27,6 +27,8 @@
 #include "periph_conf.h"
 #include "periph/hwcrypto.h"
 
+#include "clk.h"
+
 #include "em_cmu.h"
 #include "em_crypto.h"
 
@@ -42,10 +44,8 @@ static mutex_t hwcrypto_lock = MUTEX_INIT;
 
 int hwcrypto_init(void)
 {
-    /* enable clocks */
-    CMU_ClockEnable(cmuClock_HFPER, true);
-    CMU_ClockEnable(cmuClock_CRYPTO, true);
-
+    /* the clock is enabled while the hardware is acquired only (see
+       hwcrypto_acquire) */
     return 0;
 }
 
@@ -257,11 +257,15 @@ int hwcrypto_acquire(void)
 {
     mutex_lock((mutex_t *) &hwcrypto_lock);
 
+    clk_acquire(cmuClock_CRYPTO);
+
     return 0;
 }
 
 int hwcrypto_release(void)
 {
+    clk_release(cmuClock_CRYPTO);
+
     mutex_unlock((mutex_t *) &hwcrypto_lock);
 
     return 0;
@@ -269,12 +273,12 @@ int hwcrypto_release(void)
 
 void hwcrypto_poweron(void)
 {
-    CMU_ClockEnable(cmuClock_CRYPTO, true);
+    /* the clock is enabled while the hardware is acquired only */
 }
 
 void hwcrypto_poweroff(void)
 {
-    CMU_ClockEnable(cmuClock_CRYPTO, false);
+    /* the clock is gated when the hardware is released */
 }
 
 #endif /* _SILICON_LABS_32B_PLATFORM_2 */
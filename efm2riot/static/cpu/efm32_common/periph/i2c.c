@@ -25,6 +25,12 @@
 #include "periph/i2c.h"
 #include "periph/gpio.h"
 
+#include "clk.h"
+
+#ifdef MODULE_PM_LAYERED
+#include "pm_layered.h"
+#endif
+
 /* emlib uses the same flags, undefine fist */
 #undef I2C_FLAG_WRITE
 #undef I2C_FLAG_READ
@@ -47,6 +53,35 @@ static mutex_t i2c_lock[I2C_NUMOF] = {
 #endif
 };
 
+/**
+ * @brief   Bus speed of each initialized device
+ */
+static uint32_t i2c_speed[I2C_NUMOF];
+
+/**
+ * @brief   Notifier, to update the bus speeds when the HF clock changes
+ */
+static clk_notifier_t i2c_notifier;
+
+/**
+ * @brief   Recompute the clock dividers from the new HF clock.
+ */
+static void _clk_changed(void *arg)
+{
+    (void) arg;
+
+    for (i2c_t dev = 0; dev < I2C_NUMOF; dev++) {
+        if (i2c_speed[dev] == 0) {
+            continue;
+        }
+
+        clk_acquire(i2c_config[dev].cmu);
+        I2C_BusFreqSet(i2c_config[dev].dev, 0, i2c_speed[dev],
+                       i2cClockHLRStandard);
+        clk_release(i2c_config[dev].cmu);
+    }
+}
+
 /**
  * @brief   Start and track an I2C transfer.
  */
@@ -79,9 +114,16 @@ int i2c_init_master(i2c_t dev, i2c_speed_t speed)
         return -1;
     }
 
-    /* enable clocks */
-    CMU_ClockEnable(cmuClock_HFPER, true);
-    CMU_ClockEnable(i2c_config[dev].cmu, true);
+    /* the clock divider is computed from the HFXO frequency */
+    pm_hfxo_wait();
+
+    /* and updated when the HF clock changes */
+    i2c_speed[dev] = (uint32_t) speed;
+    clk_notifier_add(&i2c_notifier, _clk_changed, NULL);
+
+    /* the clock is only enabled while configuring, and during a transaction
+       (see i2c_acquire), the configuration is retained in between */
+    clk_acquire(i2c_config[dev].cmu);
 
     /* configure the pins */
     gpio_init(i2c_config[dev].scl_pin, GPIO_OD);
@@ -118,6 +160,8 @@ int i2c_init_master(i2c_t dev, i2c_speed_t speed)
     /* enable peripheral */
     I2C_Enable(i2c_config[dev].dev, true);
 
+    clk_release(i2c_config[dev].cmu);
+
     return 0;
 }
 
@@ -125,11 +169,24 @@ int i2c_acquire(i2c_t dev)
 {
     mutex_lock((mutex_t *) &i2c_lock[dev]);
 
+    clk_acquire(i2c_config[dev].cmu);
+
+#ifdef MODULE_PM_LAYERED
+    /* the peripheral needs the high-frequency clock during a transaction */
+    pm_block(EFM32_PM_MODE_EM2);
+#endif
+
     return 0;
 }
 
 int i2c_release(i2c_t dev)
 {
+#ifdef MODULE_PM_LAYERED
+    pm_unblock(EFM32_PM_MODE_EM2);
+#endif
+
+    clk_release(i2c_config[dev].cmu);
+
     mutex_unlock((mutex_t *) &i2c_lock[dev]);
 
     return 0;
@@ -239,12 +296,12 @@ int i2c_write_regs(i2c_t dev, uint8_t address, uint8_t reg,
 
 void i2c_poweron(i2c_t dev)
 {
-    CMU_ClockEnable(i2c_config[dev].cmu, true);
+    /* the clock is enabled during a transaction only (see i2c_acquire) */
 }
 
 void i2c_poweroff(i2c_t dev)
 {
-    CMU_ClockEnable(i2c_config[dev].cmu, false);
+    /* the clock is gated outside of a transaction (see i2c_release) */
 }
 
 #ifdef I2C_0_ISR
@@ -18,29 +18,403 @@
  * @}
  */
 
+#include <string.h>
+
+#include "cpu.h"
+#include "irq.h"
+
+#include "periph_conf.h"
 #include "periph/pm.h"
 
+#include "clk.h"
+#include "cpu_load.h"
+
+#include "em_cmu.h"
 #include "em_emu.h"
 
-void pm_set(unsigned mode)
+#if PM_STATS_ENABLED
+#include "cpu_cycles.h"
+#include "periph/rtt.h"
+#endif
+
+/**
+ * @brief   Retention registers that keep the retained section in EM4.
+ * @{
+ */
+#if defined(RTCC_COUNT) && RTCC_COUNT > 0
+#define RETAINED_CLOCK      cmuClock_RTCC
+#define RETAINED_REG(i)     (RTCC->RET[(i)].REG)
+#elif defined(BURTC_COUNT) && BURTC_COUNT > 0 && BURTC_ENABLED
+#define RETAINED_CLOCK      cmuClock_CORELE
+/* the first two registers are used by the RTT (see rtt_burtc.c) */
+#define RETAINED_REG(i)     (BURTC->RET[(i) + 2].REG)
+#endif
+/** @} */
+
+/**
+ * @brief   Bounds of the retained section (see the linker script).
+ * @{
+ */
+extern uint32_t _sretained[];
+extern uint32_t _eretained[];
+/** @} */
+
+/**
+ * @brief   True while the HFXO is starting, after waking up from EM2/EM3.
+ */
+static volatile bool hfxo_pending;
+
+/**
+ * @brief   Select the HFXO (which must be ready), and notify the drivers.
+ */
+static void _hfxo_select(void)
+{
+    CMU_IntDisable(CMU_IEN_HFXORDY);
+    CMU_IntClear(CMU_IFC_HFXORDY);
+
+    CMU_ClockSelectSet(cmuClock_HF, cmuSelect_HFXO);
+    CMU_OscillatorEnable(cmuOsc_HFRCO, false, false);
+
+    hfxo_pending = false;
+
+    clk_notify();
+}
+
+#if PM_STATS_ENABLED
+/**
+ * @brief   The RTT stops in EM3 together with its oscillator, unless it is the
+ *          BURTC, which keeps its oscillator running.
+ */
+#if BURTC_ENABLED && defined(BURTC_COUNT)
+#define STATS_EM3_COUNTED   (1)
+#else
+#define STATS_EM3_COUNTED   (0)
+#endif
+
+/**
+ * @brief   Collected statistics, the RTT counter at the last transition, and
+ *          the cycle counter and core clock frequency after waking up.
+ * @{
+ */
+static pm_stats_t stats;
+static uint32_t stats_mark;
+static uint32_t stats_wake_cycles;
+static uint32_t stats_wake_freq;
+/** @} */
+
+/**
+ * @brief   Number of RTT ticks since the last transition, which becomes the
+ *          new mark. The counter wraps at RTT_MAX_VALUE, which is 2^n - 1.
+ */
+static uint32_t stats_elapsed(void)
+{
+    uint32_t now = rtt_get_counter();
+    uint32_t elapsed = (now - stats_mark) & RTT_MAX_VALUE;
+
+    stats_mark = now;
+
+    return elapsed;
+}
+
+/**
+ * @brief   Add RTT ticks to the residency of a power mode, unless the RTT did
+ *          not count in it.
+ */
+static void stats_add(unsigned mode, uint32_t ticks)
+{
+    if (mode != EFM32_PM_MODE_EM3 || STATS_EM3_COUNTED) {
+        stats.residency[mode] += ticks;
+    }
+}
+
+/**
+ * @brief   Account the time spent in EM0, before entering a power mode.
+ */
+static void stats_enter(unsigned mode)
+{
+    stats.residency[PM_STATS_EM0] += stats_elapsed();
+    stats.entries[mode]++;
+}
+
+/**
+ * @brief   Account the time spent in a power mode, and count the interrupts
+ *          that woke up the MCU. They are still pending, since pm_set is
+ *          called with interrupts disabled.
+ */
+static void stats_wake(unsigned mode)
+{
+    stats_wake_cycles = cpu_cycles_get();
+    stats_wake_freq = SystemCoreClockGet();
+
+    stats_add(mode, stats_elapsed());
+
+    for (unsigned i = 0; i < EXT_IRQ_COUNT; i++) {
+        if (NVIC->ISPR[i >> 5] & (1UL << (i & 31))) {
+            stats.wakeups[i]++;
+        }
+    }
+}
+
+/**
+ * @brief   Add the time it took to restore the clocks to the latency
+ *          histogram, in microseconds. It is measured with the cycle counter,
+ *          at the frequency the core woke up at (the HF clock is switched at
+ *          the end). It is part of the residency in the power mode.
+ */
+static void stats_ready(unsigned mode)
+{
+    uint32_t cycles = (cpu_cycles_get() - stats_wake_cycles) & CPU_CYCLES_MASK;
+    uint32_t latency = ((uint64_t) cycles * 1000000U) / stats_wake_freq;
+    unsigned bin = 0;
+
+    stats_add(mode, stats_elapsed());
+
+    while (latency != 0 && bin < PM_STATS_LATENCY_BINS - 1) {
+        latency >>= 1;
+        bin++;
+    }
+
+    stats.latency[bin]++;
+}
+#else
+#define stats_enter(mode)
+#define stats_wake(mode)
+#define stats_ready(mode)
+#endif
+
+#if PM_ASYNC_HFXO_ENABLED || PM_STATS_ENABLED
+/**
+ * @brief   Enter EM2 or EM3 without restoring the clocks, so execution resumes
+ *          on the HFRCO directly. The other oscillators that were enabled are
+ *          started again, without waiting for them.
+ */
+static void _enter(unsigned mode)
+{
+    uint32_t status = CMU->STATUS;
+
+    if (mode == EFM32_PM_MODE_EM3) {
+        EMU_EnterEM3(false);
+    }
+    else {
+        EMU_EnterEM2(false);
+    }
+
+    stats_wake(mode);
+
+    /* the low-frequency oscillators stop in EM3 */
+    if (status & CMU_STATUS_LFXOENS) {
+        CMU_OscillatorEnable(cmuOsc_LFXO, true, false);
+    }
+    if (status & CMU_STATUS_LFRCOENS) {
+        CMU_OscillatorEnable(cmuOsc_LFRCO, true, false);
+    }
+    if (status & CMU_STATUS_AUXHFRCOENS) {
+        CMU_OscillatorEnable(cmuOsc_AUXHFRCO, true, false);
+    }
+}
+#endif
+
+static void _set(unsigned mode)
 {
+    stats_enter(mode);
+
+#if PM_ASYNC_HFXO_ENABLED
+    /* the HF clock may have been changed at runtime (see clk_hf_set_hfrco) */
+    if (mode != EFM32_PM_MODE_EM1 &&
+        CMU_ClockSelectGet(cmuClock_HF) == cmuSelect_HFXO) {
+        _enter(mode);
+        pm_hfxo_start();
+        stats_ready(mode);
+        return;
+    }
+#endif
+
     switch (mode) {
-        case 0:
+#if PM_STATS_ENABLED
+        case EFM32_PM_MODE_EM3:
+        case EFM32_PM_MODE_EM2: {
+            /* restore the HF clock here instead of in emlib, so waking up is
+               timestamped before waiting for the oscillator to start */
+            CMU_Select_TypeDef hf = CMU_ClockSelectGet(cmuClock_HF);
+
+            _enter(mode);
+
+            if (hf != cmuSelect_HFRCO) {
+                CMU_ClockSelectSet(cmuClock_HF, hf);
+                CMU_OscillatorEnable(cmuOsc_HFRCO, false, false);
+            }
+            break;
+        }
+#else
+        case EFM32_PM_MODE_EM3:
             /* after exiting EM3, clocks are restored */
             EMU_EnterEM3(true);
             break;
-        case 1:
+        case EFM32_PM_MODE_EM2:
             /* after exiting EM2, clocks are restored */
             EMU_EnterEM2(true);
             break;
-        case 2:
+#endif
+        case EFM32_PM_MODE_EM1:
             /* wait for next event or interrupt */
             EMU_EnterEM1();
-            break;
+            stats_wake(mode);
+            return;
     }
+
+    /* the HFRCO was stopped during the current measurement */
+    clk_hfrco_cal_restart();
+
+    stats_ready(mode);
+}
+
+void pm_set(unsigned mode)
+{
+#if CPU_LOAD_ENABLED
+    cpu_load_sleep();
+    _set(mode);
+    cpu_load_wake();
+#else
+    _set(mode);
+#endif
 }
 
 void pm_off(void)
 {
+    pm_retained_save();
+
+#if defined(RETAINED_REG) && defined(_SILICON_LABS_32B_PLATFORM_2)
+    /* the retention registers of the RTCC are only kept in EM4H, so
+       hibernate if there is anything to retain. Keep the LFE oscillator
+       running, so reading them after waking up does not wait for it to
+       start again */
+    if (_eretained - _sretained > 0) {
+        EMU->EM4CTRL |= EMU_EM4CTRL_EM4STATE_EM4H |
+                        ((CLOCK_LFE == cmuSelect_LFXO) ? EMU_EM4CTRL_RETAINLFXO : 0) |
+                        ((CLOCK_LFE == cmuSelect_LFRCO) ? EMU_EM4CTRL_RETAINLFRCO : 0);
+    }
+#endif
+
+#if EM4_HIBERNATE_ENABLED && defined(_SILICON_LABS_32B_PLATFORM_2)
+    /* in EM4H, the RTCC keeps running, and can wake up the MCU */
+    if (CMU->LFECLKEN0 & CMU_LFECLKEN0_RTCC) {
+        RTCC->EM4WUEN = RTCC_EM4WUEN_EM4WU;
+    }
+#endif
+
     EMU_EnterEM4();
 }
+
+void pm_retained_save(void)
+{
+#ifdef RETAINED_REG
+    unsigned numof = _eretained - _sretained;
+
+    clk_acquire(RETAINED_CLOCK);
+
+    for (unsigned i = 0; i < numof; i++) {
+        RETAINED_REG(i) = _sretained[i];
+    }
+
+    clk_release(RETAINED_CLOCK);
+#endif
+}
+
+void pm_retained_restore(void)
+{
+    unsigned numof = _eretained - _sretained;
+
+#ifdef RETAINED_REG
+    if (cpu_woke_from_em4()) {
+        clk_acquire(RETAINED_CLOCK);
+
+        for (unsigned i = 0; i < numof; i++) {
+            _sretained[i] = RETAINED_REG(i);
+        }
+
+        clk_release(RETAINED_CLOCK);
+
+        return;
+    }
+#endif
+
+    for (unsigned i = 0; i < numof; i++) {
+        _sretained[i] = 0;
+    }
+}
+
+void pm_hfxo_start(void)
+{
+    hfxo_pending = true;
+
+    CMU_IntClear(CMU_IFC_HFXORDY);
+    CMU_IntEnable(CMU_IEN_HFXORDY);
+
+    NVIC_ClearPendingIRQ(CMU_IRQn);
+    NVIC_EnableIRQ(CMU_IRQn);
+
+    CMU_OscillatorEnable(cmuOsc_HFXO, true, false);
+}
+
+void pm_hfxo_wait(void)
+{
+    if (!hfxo_pending) {
+        return;
+    }
+
+    unsigned int cpsr = irq_disable();
+
+    /* poll, since the interrupt cannot fire if interrupts are disabled */
+    if (hfxo_pending) {
+        while (!(CMU->STATUS & CMU_STATUS_HFXORDY)) {}
+
+        _hfxo_select();
+    }
+
+    irq_restore(cpsr);
+}
+
+void pm_stats_get(pm_stats_t *dest)
+{
+#if PM_STATS_ENABLED
+    unsigned int cpsr = irq_disable();
+
+    *dest = stats;
+
+    /* include the time spent in EM0 since the last transition */
+    dest->residency[PM_STATS_EM0] += (rtt_get_counter() - stats_mark) &
+                                     RTT_MAX_VALUE;
+
+    if (!STATS_EM3_COUNTED) {
+        dest->residency[EFM32_PM_MODE_EM3] = PM_STATS_UNAVAILABLE;
+    }
+
+    irq_restore(cpsr);
+#else
+    memset(dest, 0, sizeof(pm_stats_t));
+#endif
+}
+
+void pm_stats_reset(void)
+{
+#if PM_STATS_ENABLED
+    unsigned int cpsr = irq_disable();
+
+    memset(&stats, 0, sizeof(stats));
+    stats_mark = rtt_get_counter();
+
+    irq_restore(cpsr);
+#endif
+}
+
+void isr_cmu(void)
+{
+    if ((CMU_IntGet() & CMU_IF_HFXORDY) && hfxo_pending) {
+        _hfxo_select();
+    }
+    if (CMU_IntGetEnabled() & CMU_IF_CALRDY) {
+        clk_hfrco_cal_isr();
+    }
+
+    cortexm_isr_end();
+}
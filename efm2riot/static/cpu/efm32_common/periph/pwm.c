@@ -22,11 +22,120 @@
 #include "periph/gpio.h"
 #include "periph/pwm.h"
 
+#include "clk.h"
+
+#ifdef MODULE_PM_LAYERED
+#include "pm_layered.h"
+#endif
+
 #include "em_cmu.h"
 #include "em_timer.h"
 #include "em_timer_utils.h"
 #include "em_common_utils.h"
 
+/**
+ * @brief   Track if the clock of a device is acquired, while it is powered
+ */
+static bool pwm_powered[PWM_NUMOF];
+
+#ifdef MODULE_PM_LAYERED
+/**
+ * @brief   Track if a device blocks a power mode, while it is running
+ */
+static bool pwm_blocked[PWM_NUMOF];
+#endif
+
+/**
+ * @brief   Frequency and resolution of each initialized device
+ * @{
+ */
+static uint32_t pwm_freq[PWM_NUMOF];
+static uint16_t pwm_res[PWM_NUMOF];
+/** @} */
+
+/**
+ * @brief   Notifier, to update the prescalers when the HF clock changes
+ */
+static clk_notifier_t pwm_notifier;
+
+/**
+ * @brief   Determine the best prescaler for the frequency and resolution of
+ *          a device.
+ */
+static TIMER_Prescale_TypeDef _prescaler(pwm_t dev)
+{
+    uint32_t freq_timer = CMU_ClockFreqGet(pwm_config[dev].cmu);
+
+    return TIMER_PrescalerCalc(pwm_freq[dev] * pwm_res[dev], freq_timer);
+}
+
+/**
+ * @brief   Update the prescalers of the powered devices from the new HF
+ *          clock. A prescaler that is out of range is left unchanged.
+ */
+static void _clk_changed(void *arg)
+{
+    (void) arg;
+
+    for (pwm_t dev = 0; dev < PWM_NUMOF; dev++) {
+        if (!pwm_powered[dev]) {
+            continue;
+        }
+
+        TIMER_Prescale_TypeDef prescaler = _prescaler(dev);
+
+        if (prescaler <= timerPrescale1024) {
+            pwm_config[dev].dev->CTRL =
+                (pwm_config[dev].dev->CTRL & ~_TIMER_CTRL_PRESC_MASK) |
+                (prescaler << _TIMER_CTRL_PRESC_SHIFT);
+        }
+    }
+}
+
+/**
+ * @brief   Acquire (or release) the clock of a device, while it is powered.
+ */
+static void _powered(pwm_t dev, bool powered)
+{
+    if (pwm_powered[dev] == powered) {
+        return;
+    }
+
+    if (powered) {
+        clk_acquire(pwm_config[dev].cmu);
+    }
+    else {
+        clk_release(pwm_config[dev].cmu);
+    }
+
+    pwm_powered[dev] = powered;
+}
+
+/**
+ * @brief   Block (or unblock) EM2, in which the timer stops, while the device
+ *          is running.
+ */
+static void _pm_running(pwm_t dev, bool running)
+{
+#ifdef MODULE_PM_LAYERED
+    if (pwm_blocked[dev] == running) {
+        return;
+    }
+
+    if (running) {
+        pm_block(EFM32_PM_MODE_EM2);
+    }
+    else {
+        pm_unblock(EFM32_PM_MODE_EM2);
+    }
+
+    pwm_blocked[dev] = running;
+#else
+    (void) dev;
+    (void) running;
+#endif
+}
+
 uint32_t pwm_init(pwm_t dev, pwm_mode_t mode, uint32_t freq, uint16_t res)
 {
     /* check if device is valid */
@@ -34,14 +143,20 @@ uint32_t pwm_init(pwm_t dev, pwm_mode_t mode, uint32_t freq, uint16_t res)
         return -1;
     }
 
+    /* the prescaler is computed from the HFXO frequency, and updated when
+       the HF clock changes */
+    pm_hfxo_wait();
+
+    pwm_freq[dev] = freq;
+    pwm_res[dev] = res;
+    clk_notifier_add(&pwm_notifier, _clk_changed, NULL);
+
     /* enable clocks */
-    CMU_ClockEnable(cmuClock_HFPER, true);
-    CMU_ClockEnable(pwm_config[dev].cmu, true);
+    _powered(dev, true);
 
     /* calculate the prescaler by determining the best prescaler */
     uint32_t freq_timer = CMU_ClockFreqGet(pwm_config[dev].cmu);
-    TIMER_Prescale_TypeDef prescaler = TIMER_PrescalerCalc(freq * res,
-                                                           freq_timer);
+    TIMER_Prescale_TypeDef prescaler = _prescaler(dev);
 
     if (prescaler > timerPrescale1024) {
         return -2;
@@ -84,6 +199,8 @@ uint32_t pwm_init(pwm_t dev, pwm_mode_t mode, uint32_t freq, uint16_t res)
     /* enable peripheral */
     TIMER_Enable(pwm_config[dev].dev, true);
 
+    _pm_running(dev, true);
+
     return freq_timer / TIMER_Prescaler2Div(prescaler) / res;
 }
 
@@ -104,23 +221,34 @@ void pwm_set(pwm_t dev, uint8_t channel, uint16_t value)
 void pwm_start(pwm_t dev)
 {
     assert(dev < PWM_NUMOF);
+    pm_hfxo_wait();
     TIMER_Enable(pwm_config[dev].dev, true);
+
+    _pm_running(dev, true);
 }
 
 void pwm_stop(pwm_t dev)
 {
     assert(dev < PWM_NUMOF);
     TIMER_Enable(pwm_config[dev].dev, false);
+
+    _pm_running(dev, false);
 }
 
 void pwm_poweron(pwm_t dev)
 {
     assert(dev < PWM_NUMOF);
-    CMU_ClockEnable(pwm_config[dev].cmu, true);
+    pm_hfxo_wait();
+    _powered(dev, true);
+
+    _pm_running(dev, true);
 }
 
 void pwm_poweroff(pwm_t dev)
 {
     assert(dev < PWM_NUMOF);
-    CMU_ClockEnable(pwm_config[dev].cmu, false);
+
+    _pm_running(dev, false);
+
+    _powered(dev, false);
 }
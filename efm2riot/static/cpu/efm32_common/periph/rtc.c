@@ -25,11 +25,17 @@
 #include "periph_conf.h"
 #include "periph/rtc.h"
 
+#include "clk.h"
+
+#ifdef MODULE_PM_LAYERED
+#include "pm_layered.h"
+#endif
+
 #include "em_cmu.h"
 #include "em_rtc.h"
 #include "em_common_utils.h"
 
-#if defined(RTC_COUNT) && RTC_COUNT > 0
+#if defined(RTC_COUNT) && RTC_COUNT > 0 && !(BURTC_ENABLED && defined(BURTC_COUNT))
 
 #define RTC_MAX_VALUE       (0xFFFFFF)
 #define RTC_SHIFT_VALUE     (24U)
@@ -65,15 +71,43 @@ static void _set_alarm(void)
     }
 }
 
+/**
+ * @brief   Acquire the clock, and block EM3, in which the low-frequency clocks
+ *          stop, while the RTC is powered.
+ */
+static void _powered(bool powered)
+{
+    static bool acquired;
+
+    if (acquired == powered) {
+        return;
+    }
+
+    if (powered) {
+        clk_acquire(cmuClock_RTC);
+#ifdef MODULE_PM_LAYERED
+        pm_block(EFM32_PM_MODE_EM3);
+#endif
+    }
+    else {
+#ifdef MODULE_PM_LAYERED
+        pm_unblock(EFM32_PM_MODE_EM3);
+#endif
+        clk_release(cmuClock_RTC);
+    }
+
+    acquired = powered;
+}
+
 void rtc_init(void)
 {
+    /* enable clocks, before the prescaler is set in the low-frequency
+       domain */
+    _powered(true);
+
     /* prescaler of 32768 = 1 s of resolution and overflow each 194 days */
     CMU_ClockDivSet(cmuClock_RTC, cmuClkDiv_32768);
 
-    /* enable clocks */
-    CMU_ClockEnable(cmuClock_CORELE, true);
-    CMU_ClockEnable(cmuClock_RTC, true);
-
     /* initialize the state */
     rtc_state.overflows = 0;
 
@@ -147,12 +181,12 @@ void rtc_clear_alarm(void)
 
 void rtc_poweron(void)
 {
-    CMU_ClockEnable(cmuClock_RTC, true);
+    _powered(true);
 }
 
 void rtc_poweroff(void)
 {
-    CMU_ClockEnable(cmuClock_RTC, false);
+    _powered(false);
 }
 
 void isr_rtc(void)
@@ -179,4 +213,4 @@ void isr_rtc(void)
     cortexm_isr_end();
 }
 
-#endif /* defined(RTC_COUNT) && RTC_COUNT > 0 */
+#endif /* defined(RTC_COUNT) && RTC_COUNT > 0 && !(BURTC_ENABLED && defined(BURTC_COUNT)) */
@@ -0,0 +1,233 @@
+/*
+ * Copyright (C) 2017 Bas Stottelaar <basstottelaar@gmail.com>
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     cpu_efm32_common
+ *
+ * @{
+ *
+ * @file
+ * @brief       RTC peripheral driver implementation using the BURTC, which
+ *              keeps counting in EM4
+ * @author      Bas Stottelaar <basstottelaar@gmail.com>
+ *
+ * @}
+ */
+
+#include <time.h>
+
+#include "cpu.h"
+
+#include "periph_conf.h"
+#include "periph/rtc.h"
+
+#include "clk.h"
+
+#include "em_burtc.h"
+#include "em_cmu.h"
+#include "em_emu.h"
+#include "em_rmu.h"
+#include "em_common_utils.h"
+
+#if defined(BURTC_COUNT) && BURTC_COUNT > 0 && BURTC_ENABLED
+
+#define RTC_SHIFT_VALUE     (8U)    /**< 256 Hz, the lowest BURTC frequency */
+
+/**
+ * @brief   Retention registers, which survive EM4 and resets.
+ * @{
+ */
+#define RTC_RET_OVERFLOWS   (0U)    /**< number of counter overflows */
+#define RTC_RET_OFFSET      (1U)    /**< time (in seconds) at counter zero */
+/** @} */
+
+typedef struct {
+    rtc_alarm_cb_t alarm_cb;        /**< callback called from RTC interrupt */
+    void *alarm_arg;                /**< argument passed to the callback */
+    uint32_t alarm;                 /**< scheduled alarm (may be defered) */
+} rtc_state_t;
+
+static rtc_state_t rtc_state;
+
+/**
+ * @brief   Get the number of seconds since counter zero.
+ */
+static uint32_t _get_seconds(void)
+{
+    uint32_t overflows;
+    uint32_t counter;
+    bool pending;
+
+    /* retry if an overflow was handled in between */
+    do {
+        overflows = BURTC_RetRegGet(RTC_RET_OVERFLOWS);
+        counter = BURTC_CounterGet();
+        pending = (BURTC_IntGet() & BURTC_IF_OF) != 0;
+    } while (overflows != BURTC_RetRegGet(RTC_RET_OVERFLOWS));
+
+    /* account for an overflow that is not handled yet */
+    if (pending && counter < (0xFFFFFFFF >> 1)) {
+        overflows++;
+    }
+
+    return (uint32_t) ((((uint64_t) overflows << 32) + counter) >>
+                       RTC_SHIFT_VALUE);
+}
+
+/**
+ * @brief   Actual implementation of rtc_set_alarm
+ */
+static void _set_alarm(void)
+{
+    uint64_t ticks = ((uint64_t) (rtc_state.alarm -
+                      BURTC_RetRegGet(RTC_RET_OFFSET))) << RTC_SHIFT_VALUE;
+
+    /* check if alarm is in reach of BURTC counter, which means that the
+       overflows match */
+    if ((ticks >> 32) == BURTC_RetRegGet(RTC_RET_OVERFLOWS)) {
+        /* disable interrupt so it doesn't accidentally trigger */
+        BURTC_IntDisable(BURTC_IEN_COMP0);
+
+        /* set compare register */
+        BURTC_CompareSet(0, (uint32_t) ticks);
+
+        /* (re-)enable the interrupt */
+        BURTC_IntClear(BURTC_IFC_COMP0);
+        BURTC_IntEnable(BURTC_IEN_COMP0);
+    }
+}
+
+void rtc_init(void)
+{
+    bool lfxo = (CLOCK_LFA == cmuSelect_LFXO);
+
+    /* enable clocks, and release the backup domain from reset */
+    clk_acquire(cmuClock_CORELE);
+
+    RMU_ResetControl(rmuResetBU, rmuResetModeClear);
+
+    /* keep the oscillator running in EM4, and wake up by the BURTC */
+    EFM32_CREATE_INIT(init_em4, EMU_EM4Init_TypeDef, EMU_EM4INIT_DEFAULT,
+        .conf.lockConfig = true,
+        .conf.osc = lfxo ? emuEM4Osc_LFXO : emuEM4Osc_LFRCO,
+        .conf.buRtcWakeup = true,
+        .conf.vreg = true
+    );
+
+    EMU_EM4Init(&init_em4.conf);
+
+    /* the BURTC keeps counting through EM4 and resets, so only initialize it
+       if it was reset as well (e.g. after power-on) */
+    if ((BURTC->CTRL & _BURTC_CTRL_MODE_MASK) == BURTC_CTRL_MODE_DISABLE) {
+        EFM32_CREATE_INIT(init, BURTC_Init_TypeDef, BURTC_INIT_DEFAULT,
+            .conf.enable = true,
+            .conf.mode = burtcModeEM4,
+            .conf.clkSel = lfxo ? burtcClkSelLFXO : burtcClkSelLFRCO,
+            .conf.clkDiv = burtcClkDiv_128,
+            .conf.compare0Top = false
+        );
+
+        BURTC_Reset();
+        BURTC_Init(&init.conf);
+
+        BURTC_RetRegSet(RTC_RET_OVERFLOWS, 0);
+        BURTC_RetRegSet(RTC_RET_OFFSET, 0);
+    }
+
+    /* enable interrupts (the overflow flag is retained, so an overflow that
+       woke up the MCU from EM4 is counted as well) */
+    BURTC_IntEnable(BURTC_IEN_OF);
+
+    NVIC_ClearPendingIRQ(BURTC_IRQn);
+    NVIC_EnableIRQ(BURTC_IRQn);
+}
+
+int rtc_set_time(struct tm *time)
+{
+    uint32_t timestamp = mktime(time);
+
+    /* the BURTC counter cannot be written, so store an offset instead */
+    BURTC_RetRegSet(RTC_RET_OFFSET, timestamp - _get_seconds());
+
+    return 0;
+}
+
+int rtc_get_time(struct tm *time)
+{
+    uint32_t timestamp = _get_seconds() + BURTC_RetRegGet(RTC_RET_OFFSET);
+
+    gmtime_r((time_t *) &timestamp, time);
+
+    return 0;
+}
+
+int rtc_set_alarm(struct tm *time, rtc_alarm_cb_t cb, void *arg)
+{
+    rtc_state.alarm_cb = cb;
+    rtc_state.alarm_arg = arg;
+    rtc_state.alarm = mktime(time);
+
+    /* alarm may not be in reach of current time, so defer if needed */
+    _set_alarm();
+
+    return 0;
+}
+
+int rtc_get_alarm(struct tm *time)
+{
+    gmtime_r((time_t *) &rtc_state.alarm, time);
+
+    return 0;
+}
+
+void rtc_clear_alarm(void)
+{
+    rtc_state.alarm_cb = NULL;
+    rtc_state.alarm_arg = NULL;
+    rtc_state.alarm = 0;
+
+    BURTC_IntDisable(BURTC_IEN_COMP0);
+}
+
+void rtc_poweron(void)
+{
+    /* the BURTC is part of the backup domain, and keeps running */
+}
+
+void rtc_poweroff(void)
+{
+    /* stopping the BURTC would reset the counter, which is not desired */
+}
+
+void isr_burtc(void)
+{
+    if ((BURTC_IntGet() & BURTC_IF_COMP0)) {
+        if (rtc_state.alarm_cb != NULL) {
+            rtc_state.alarm_cb(rtc_state.alarm_arg);
+        }
+
+        /* clear interrupt */
+        BURTC_IntClear(BURTC_IFC_COMP0);
+    }
+    if (BURTC_IntGet() & BURTC_IF_OF) {
+        /* clear interrupt first, so the counter does not count this
+           overflow twice */
+        BURTC_IntClear(BURTC_IFC_OF);
+
+        BURTC_RetRegSet(RTC_RET_OVERFLOWS,
+                        BURTC_RetRegGet(RTC_RET_OVERFLOWS) + 1);
+
+        /* check if alarm should be enabled now */
+        if (rtc_state.alarm_cb) {
+            _set_alarm();
+        }
+    }
+    cortexm_isr_end();
+}
+
+#endif /* defined(BURTC_COUNT) && BURTC_COUNT > 0 && BURTC_ENABLED */
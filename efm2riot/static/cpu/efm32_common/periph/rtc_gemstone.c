@@ -25,6 +25,12 @@
 #include "periph_conf.h"
 #include "periph/rtc.h"
 
+#include "clk.h"
+
+#ifdef MODULE_PM_LAYERED
+#include "pm_layered.h"
+#endif
+
 #include "em_cmu.h"
 #include "em_rtcc.h"
 #include "em_rtcc_utils.h"
@@ -33,6 +39,15 @@
 #if defined(RTCC_COUNT) && RTCC_COUNT > 0
 
 #define RTC_YEAR_OFFSET (100)       /**< RTCC has only two-digit notation */
+#define RTC_YEAR_MAX    (199)       /**< RTCC supports year 2000 up to 2099 */
+#define RTC_WDAY_OFFSET (6)         /**< January 1st, 2000 is a Saturday */
+
+/**
+ * @brief   Number of days before each month, in a non-leap year.
+ */
+static const uint16_t rtc_days_before_month[] = {
+    0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334
+};
 
 typedef struct {
     rtc_alarm_cb_t alarm_cb;        /**< callback called from RTC interrupt */
@@ -42,11 +57,54 @@ typedef struct {
 
 static rtc_state_t rtc_state;
 
+/**
+ * @brief   Compute the day of the year (zero-based), without the C library.
+ *
+ * Within the range of the RTCC, each fourth year is a leap year.
+ */
+static int _day_of_year(int year, int mon, int mday)
+{
+    int yday = rtc_days_before_month[mon] + mday - 1;
+
+    if ((year % 4) == 0 && mon > 1) {
+        yday++;
+    }
+
+    return yday;
+}
+
+/**
+ * @brief   Acquire the clock, and block EM3, in which the low-frequency clocks
+ *          stop, while the RTC is powered.
+ */
+static void _powered(bool powered)
+{
+    static bool acquired;
+
+    if (acquired == powered) {
+        return;
+    }
+
+    if (powered) {
+        clk_acquire(cmuClock_RTCC);
+#ifdef MODULE_PM_LAYERED
+        pm_block(EFM32_PM_MODE_EM3);
+#endif
+    }
+    else {
+#ifdef MODULE_PM_LAYERED
+        pm_unblock(EFM32_PM_MODE_EM3);
+#endif
+        clk_release(cmuClock_RTCC);
+    }
+
+    acquired = powered;
+}
+
 void rtc_init(void)
 {
     /* enable clocks */
-    CMU_ClockEnable(cmuClock_CORELE, true);
-    CMU_ClockEnable(cmuClock_RTCC, true);
+    _powered(true);
 
     /* reset and initialize peripheral */
     EFM32_CREATE_INIT(init, RTCC_Init_TypeDef, RTCC_INIT_DEFAULT,
@@ -73,37 +131,71 @@ void rtc_init(void)
 
 int rtc_set_time(struct tm *time)
 {
+    /* check if time is in range of the RTCC */
+    if (time->tm_year < RTC_YEAR_OFFSET || time->tm_year > RTC_YEAR_MAX) {
+        return -1;
+    }
+
+    int year = time->tm_year - RTC_YEAR_OFFSET;
+    int yday = _day_of_year(year, time->tm_mon, time->tm_mday);
+
+    /* days since January 1st, 2000 determine the day of the week */
+    int days = (year * 365) + ((year + 3) / 4) + yday;
+
+    /* stop the calendar, so no carry occurs between writing the date and
+       time, and restart the current second */
+    RTCC_Enable(false);
+
+    RTCC->PRECNT = 0;
+
     RTCC_DateSet(
-        RTCC_Year2BCD(time->tm_year - RTC_YEAR_OFFSET) |
+        RTCC_Year2BCD(year) |
         RTCC_Month2BCD(time->tm_mon) |
         RTCC_DayOfMonth2BCD(time->tm_mday) |
-        RTCC_DayOfWeek2BCD(time->tm_wday));
+        RTCC_DayOfWeek2BCD((days + RTC_WDAY_OFFSET) % 7));
     RTCC_TimeSet(
         RTCC_Hour2BCD(time->tm_hour) |
         RTCC_Minute2BCD(time->tm_min) |
         RTCC_Second2BCD(time->tm_sec));
 
+    RTCC_Enable(true);
+
     return 0;
 }
 
 int rtc_get_time(struct tm *time)
 {
-    uint32_t datestamp = RTCC_DateGet();
-    uint32_t timestamp = RTCC_TimeGet();
+    uint32_t datestamp;
+    uint32_t timestamp;
+
+    /* read again if the date changed while reading the time (at midnight),
+       so both are consistent */
+    do {
+        datestamp = RTCC_DateGet();
+        timestamp = RTCC_TimeGet();
+    } while (datestamp != RTCC_DateGet());
 
     time->tm_year = RTCC_BCD2Year(datestamp) + RTC_YEAR_OFFSET;
     time->tm_mon  = RTCC_BCD2Month(datestamp);
     time->tm_mday = RTCC_BCD2DayOfMonth(datestamp);
     time->tm_wday = RTCC_BCD2DayOfWeek(datestamp);
+    time->tm_yday = _day_of_year(RTCC_BCD2Year(datestamp),
+                                 time->tm_mon, time->tm_mday);
     time->tm_hour = RTCC_BCD2Hour(timestamp);
     time->tm_min  = RTCC_BCD2Minute(timestamp);
     time->tm_sec  = RTCC_BCD2Second(timestamp);
+    time->tm_isdst = 0;
 
     return 0;
 }
 
 int rtc_set_alarm(struct tm *time, rtc_alarm_cb_t cb, void *arg)
 {
+    /* check if alarm is in range of the RTCC */
+    if (time->tm_year < RTC_YEAR_OFFSET || time->tm_year > RTC_YEAR_MAX) {
+        return -1;
+    }
+
     rtc_state.alarm_cb = cb;
     rtc_state.alarm_arg = arg;
     rtc_state.alarm_year = time->tm_year;
@@ -135,6 +227,8 @@ int rtc_get_alarm(struct tm *time)
     time->tm_year = rtc_state.alarm_year;
     time->tm_mon  = RTCC_Channel_BCD2Month(datestamp);
     time->tm_mday = RTCC_Channel_BCD2Day(datestamp);
+    time->tm_yday = _day_of_year(time->tm_year - RTC_YEAR_OFFSET,
+                                 time->tm_mon, time->tm_mday);
     time->tm_hour = RTCC_Channel_BCD2Hour(timestamp);
     time->tm_min  = RTCC_Channel_BCD2Minute(timestamp);
     time->tm_sec  = RTCC_Channel_BCD2Second(timestamp);
@@ -153,12 +247,12 @@ void rtc_clear_alarm(void)
 
 void rtc_poweron(void)
 {
-    CMU_ClockEnable(cmuClock_RTCC, true);
+    _powered(true);
 }
 
 void rtc_poweroff(void)
 {
-    CMU_ClockEnable(cmuClock_RTCC, false);
+    _powered(false);
 }
 
 void isr_rtcc(void)
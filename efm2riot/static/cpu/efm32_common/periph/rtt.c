@@ -23,29 +23,76 @@
 #include "periph_conf.h"
 #include "periph/rtt.h"
 
+#include "clk.h"
+
+#ifdef MODULE_PM_LAYERED
+#include "pm_layered.h"
+#endif
+
 #include "em_cmu.h"
 #include "em_rtc.h"
 #include "em_common_utils.h"
 
-#if defined(RTC_COUNT) && RTC_COUNT > 0
+#if defined(RTC_COUNT) && RTC_COUNT > 0 && !(BURTC_ENABLED && defined(BURTC_COUNT))
+
+/**
+ * @brief   Prescaler of the 32768 Hz low-frequency clock, to achieve the
+ *          configured RTT frequency.
+ */
+#define RTT_PRESCALER       (32768U / RTT_FREQUENCY)
+
+#if (RTT_FREQUENCY > 32768U) || (RTT_PRESCALER & (RTT_PRESCALER - 1)) != 0
+#error "RTT_FREQUENCY must be a power of two, up to 32768 Hz."
+#endif
 
 typedef struct {
     rtt_cb_t alarm_cb;              /**< callback called from RTC alarm */
     void *alarm_arg;                /**< argument passed to the callback */
     rtt_cb_t overflow_cb;           /**< callback called when RTC overflows */
     void *overflow_arg;             /**< argument passed to the callback */
+    volatile uint32_t overflows;    /**< number of counter overflows */
+    rtt_alarm_t *alarms;            /**< sorted list of software alarms */
 } rtt_state_t;
 
 static rtt_state_t rtt_state;
 
+/**
+ * @brief   Acquire the clock, and block EM3, in which the low-frequency clocks
+ *          stop, while the RTT is powered.
+ */
+static void _powered(bool powered)
+{
+    static bool acquired;
+
+    if (acquired == powered) {
+        return;
+    }
+
+    if (powered) {
+        clk_acquire(cmuClock_RTC);
+#ifdef MODULE_PM_LAYERED
+        pm_block(EFM32_PM_MODE_EM3);
+#endif
+    }
+    else {
+#ifdef MODULE_PM_LAYERED
+        pm_unblock(EFM32_PM_MODE_EM3);
+#endif
+        clk_release(cmuClock_RTC);
+    }
+
+    acquired = powered;
+}
+
 void rtt_init(void)
 {
-    /* prescaler of 32768 = 1 s of resolution and overflow each 194 days */
-    CMU_ClockDivSet(cmuClock_RTC, cmuClkDiv_32768);
+    /* enable clocks, before the prescaler is set in the low-frequency
+       domain */
+    _powered(true);
 
-    /* enable clocks */
-    CMU_ClockEnable(cmuClock_CORELE, true);
-    CMU_ClockEnable(cmuClock_RTC, true);
+    /* prescaler of 32768 = 1 s of resolution and overflow each 194 days,
+       prescaler of 1 = 30.5 us of resolution and overflow each 512 s */
+    CMU_ClockDivSet(cmuClock_RTC, (CMU_ClkDiv_TypeDef) RTT_PRESCALER);
 
     /* reset and initialize peripheral */
     EFM32_CREATE_INIT(init, RTC_Init_TypeDef, RTC_INIT_DEFAULT,
@@ -56,7 +103,7 @@ void rtt_init(void)
     RTC_Reset();
     RTC_Init(&init.conf);
 
-    /* enable interrupts */
+    /* enable interrupts (overflows are always counted) */
     RTC_IntEnable(RTC_IEN_OF);
 
     NVIC_ClearPendingIRQ(RTC_IRQn);
@@ -70,17 +117,12 @@ void rtt_set_overflow_cb(rtt_cb_t cb, void *arg)
 {
     rtt_state.overflow_cb = cb;
     rtt_state.overflow_arg = arg;
-
-    RTC_IntClear(RTC_IFC_OF);
-    RTC_IntEnable(RTC_IEN_OF);
 }
 
 void rtt_clear_overflow_cb(void)
 {
     rtt_state.overflow_cb = NULL;
     rtt_state.overflow_arg = NULL;
-
-    RTC_IntDisable(RTC_IEN_OF);
 }
 
 uint32_t rtt_get_counter(void)
@@ -88,6 +130,28 @@ uint32_t rtt_get_counter(void)
     return RTC_CounterGet();
 }
 
+uint64_t rtt_get_counter64(void)
+{
+    uint32_t overflows;
+    uint32_t counter;
+    bool pending;
+
+    /* retry if an overflow was handled in between */
+    do {
+        overflows = rtt_state.overflows;
+        counter = RTC_CounterGet();
+        pending = (RTC_IntGet() & RTC_IF_OF) != 0;
+    } while (overflows != rtt_state.overflows);
+
+    /* account for an overflow that is not handled yet (e.g. interrupts are
+       disabled), if the counter wrapped before it was read */
+    if (pending && counter < (RTT_MAX_VALUE >> 1)) {
+        overflows++;
+    }
+
+    return ((uint64_t) overflows * (RTT_MAX_VALUE + 1ULL)) + counter;
+}
+
 void rtt_set_counter(uint32_t counter)
 {
     RTC->CNT = counter & RTT_MAX_VALUE;
@@ -123,14 +187,121 @@ void rtt_clear_alarm(void)
     RTC_IntDisable(RTC_IEN_COMP0);
 }
 
+/**
+ * @brief   Program the compare channel for the first alarm in the list.
+ *
+ * Must be called with interrupts disabled.
+ */
+static void _alarm_program(void)
+{
+    rtt_alarm_t *head = rtt_state.alarms;
+
+    /* disable interrupt so it doesn't accidentally trigger */
+    RTC_IntDisable(RTC_IEN_COMP1);
+
+    if (head == NULL) {
+        return;
+    }
+
+    RTC_CompareSet(1, head->target & RTT_MAX_VALUE);
+    RTC_IntClear(RTC_IFC_COMP1);
+    RTC_IntEnable(RTC_IEN_COMP1);
+
+    /* the deadline may have passed while programming, so trigger the
+       interrupt manually */
+    if (head->target <= rtt_get_counter64()) {
+        RTC_IntSet(RTC_IFS_COMP1);
+    }
+}
+
+void rtt_alarm_add(rtt_alarm_t *alarm, uint64_t target,
+                   void (*cb)(void *arg), void *arg)
+{
+    unsigned int cpsr = irq_disable();
+
+    alarm->target = target;
+    alarm->cb = cb;
+    alarm->arg = arg;
+
+    /* insert sorted, after alarms with the same deadline */
+    rtt_alarm_t **node = &rtt_state.alarms;
+
+    while (*node != NULL && (*node)->target <= target) {
+        node = &(*node)->next;
+    }
+
+    alarm->next = *node;
+    *node = alarm;
+
+    /* only reprogram if the first alarm changed */
+    if (rtt_state.alarms == alarm) {
+        _alarm_program();
+    }
+
+    irq_restore(cpsr);
+}
+
+void rtt_alarm_remove(rtt_alarm_t *alarm)
+{
+    unsigned int cpsr = irq_disable();
+
+    rtt_alarm_t **node = &rtt_state.alarms;
+
+    while (*node != NULL && *node != alarm) {
+        node = &(*node)->next;
+    }
+
+    if (*node != NULL) {
+        bool head = (node == &rtt_state.alarms);
+
+        *node = alarm->next;
+
+        if (head) {
+            _alarm_program();
+        }
+    }
+
+    irq_restore(cpsr);
+}
+
+/**
+ * @brief   Run all expired alarms, and program the next one.
+ */
+static void _alarm_expire(void)
+{
+    uint64_t now = rtt_get_counter64();
+
+    while (1) {
+        /* unlink with interrupts disabled, since a higher priority interrupt
+           may add or remove an alarm */
+        unsigned int cpsr = irq_disable();
+        rtt_alarm_t *alarm = rtt_state.alarms;
+
+        if (alarm == NULL || alarm->target > now) {
+            irq_restore(cpsr);
+            break;
+        }
+
+        rtt_state.alarms = alarm->next;
+        irq_restore(cpsr);
+
+        /* the callback may add this alarm again */
+        alarm->cb(alarm->arg);
+    }
+
+    unsigned int cpsr = irq_disable();
+    _alarm_program();
+    irq_restore(cpsr);
+}
+
 void rtt_poweron(void)
 {
-    CMU_ClockEnable(cmuClock_RTC, true);
+    _powered(true);
 }
 
 void rtt_poweroff(void)
 {
-    CMU_ClockEnable(cmuClock_RTC, false);
+    _powered(false);
 }
 
 void isr_rtc(void)
@@ -143,15 +314,24 @@ void isr_rtc(void)
         /* clear interrupt */
         RTC_IntClear(RTC_IFC_COMP0);
     }
+    if (RTC_IntGet() & RTC_IF_COMP1) {
+        /* clear interrupt */
+        RTC_IntClear(RTC_IFC_COMP1);
+
+        _alarm_expire();
+    }
     if (RTC_IntGet() & RTC_IF_OF) {
+        /* clear interrupt first, so rtt_get_counter64 does not count this
+           overflow twice */
+        RTC_IntClear(RTC_IFC_OF);
+
+        rtt_state.overflows++;
+
         if (rtt_state.overflow_cb != NULL) {
             rtt_state.overflow_cb(rtt_state.overflow_arg);
         }
-
-        /* clear interrupt */
-        RTC_IntClear(RTC_IFC_OF);
     }
     cortexm_isr_end();
 }
 
-#endif /* defined(RTC_COUNT) && RTC_COUNT > 0 */
+#endif /* defined(RTC_COUNT) && RTC_COUNT > 0 && !(BURTC_ENABLED && defined(BURTC_COUNT)) */
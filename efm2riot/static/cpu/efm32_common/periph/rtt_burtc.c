@@ -0,0 +1,243 @@
+/*
+ * Copyright (C) 2017 Bas Stottelaar <basstottelaar@gmail.com>
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     cpu_efm32_common
+ *
+ * @{
+ *
+ * @file
+ * @brief       RTT peripheral driver implementation using the BURTC, which
+ *              keeps counting in EM4
+ * @author      Bas Stottelaar <basstottelaar@gmail.com>
+ *
+ * @}
+ */
+
+#include "cpu.h"
+#include "irq.h"
+
+#include "periph_conf.h"
+#include "periph/rtt.h"
+
+#include "clk.h"
+
+#include "em_burtc.h"
+#include "em_cmu.h"
+#include "em_emu.h"
+#include "em_rmu.h"
+#include "em_common_utils.h"
+
+#if defined(BURTC_COUNT) && BURTC_COUNT > 0 && BURTC_ENABLED
+
+/**
+ * @brief   Prescaler of the 32768 Hz low-frequency clock, to achieve the
+ *          configured RTT frequency.
+ */
+#define RTT_PRESCALER       (32768U / RTT_FREQUENCY)
+
+#if (RTT_FREQUENCY > 32768U) || (RTT_PRESCALER > 128U) || \
+    (RTT_PRESCALER & (RTT_PRESCALER - 1)) != 0
+#error "RTT_FREQUENCY must be a power of two, from 256 Hz up to 32768 Hz."
+#endif
+
+/**
+ * @brief   Retention registers, which survive EM4 and resets.
+ * @{
+ */
+#define RTT_RET_OVERFLOWS   (0U)    /**< number of counter overflows */
+#define RTT_RET_OFFSET      (1U)    /**< offset set by rtt_set_counter */
+/** @} */
+
+typedef struct {
+    rtt_cb_t alarm_cb;              /**< callback called from RTC alarm */
+    void *alarm_arg;                /**< argument passed to the callback */
+    rtt_cb_t overflow_cb;           /**< callback called when RTC overflows */
+    void *overflow_arg;             /**< argument passed to the callback */
+} rtt_state_t;
+
+static rtt_state_t rtt_state;
+
+void rtt_init(void)
+{
+    bool lfxo = (CLOCK_LFA == cmuSelect_LFXO);
+
+    /* enable clocks, and release the backup domain from reset */
+    clk_acquire(cmuClock_CORELE);
+
+    RMU_ResetControl(rmuResetBU, rmuResetModeClear);
+
+    /* keep the oscillator running in EM4, and wake up by the BURTC */
+    EFM32_CREATE_INIT(init_em4, EMU_EM4Init_TypeDef, EMU_EM4INIT_DEFAULT,
+        .conf.lockConfig = true,
+        .conf.osc = lfxo ? emuEM4Osc_LFXO : emuEM4Osc_LFRCO,
+        .conf.buRtcWakeup = true,
+        .conf.vreg = true
+    );
+
+    EMU_EM4Init(&init_em4.conf);
+
+    /* the BURTC keeps counting through EM4 and resets, so only initialize it
+       if it was reset as well (e.g. after power-on) */
+    if ((BURTC->CTRL & _BURTC_CTRL_MODE_MASK) == BURTC_CTRL_MODE_DISABLE) {
+        EFM32_CREATE_INIT(init, BURTC_Init_TypeDef, BURTC_INIT_DEFAULT,
+            .conf.enable = true,
+            .conf.mode = burtcModeEM4,
+            .conf.clkSel = lfxo ? burtcClkSelLFXO : burtcClkSelLFRCO,
+            .conf.clkDiv = RTT_PRESCALER,
+            .conf.compare0Top = false
+        );
+
+        BURTC_Reset();
+        BURTC_Init(&init.conf);
+
+        BURTC_RetRegSet(RTT_RET_OVERFLOWS, 0);
+        BURTC_RetRegSet(RTT_RET_OFFSET, 0);
+    }
+
+    /* enable interrupts (overflows are always counted, also when one woke up
+       the MCU from EM4, since the flag is retained) */
+    BURTC_IntEnable(BURTC_IEN_OF);
+
+    NVIC_ClearPendingIRQ(BURTC_IRQn);
+    NVIC_EnableIRQ(BURTC_IRQn);
+}
+
+void rtt_set_overflow_cb(rtt_cb_t cb, void *arg)
+{
+    rtt_state.overflow_cb = cb;
+    rtt_state.overflow_arg = arg;
+}
+
+void rtt_clear_overflow_cb(void)
+{
+    rtt_state.overflow_cb = NULL;
+    rtt_state.overflow_arg = NULL;
+}
+
+uint32_t rtt_get_counter(void)
+{
+    return BURTC_CounterGet() + BURTC_RetRegGet(RTT_RET_OFFSET);
+}
+
+uint64_t rtt_get_counter64(void)
+{
+    uint32_t overflows;
+    uint32_t counter;
+    uint32_t offset;
+    bool pending;
+
+    /* retry if an overflow was handled (or the counter was set) in
+       between */
+    do {
+        overflows = BURTC_RetRegGet(RTT_RET_OVERFLOWS);
+        offset = BURTC_RetRegGet(RTT_RET_OFFSET);
+        counter = BURTC_CounterGet();
+        pending = (BURTC_IntGet() & BURTC_IF_OF) != 0;
+    } while (overflows != BURTC_RetRegGet(RTT_RET_OVERFLOWS));
+
+    /* account for an overflow that is not handled yet (e.g. interrupts are
+       disabled), if the counter wrapped before it was read */
+    if (pending && counter < (RTT_MAX_VALUE >> 1)) {
+        overflows++;
+    }
+
+    /* the overflow count includes the carry of the offset (see
+       rtt_set_counter), so this wraps to the right value if needed */
+    return (((uint64_t) overflows << 32) + counter) + offset;
+}
+
+void rtt_set_counter(uint32_t counter)
+{
+    unsigned int cpsr = irq_disable();
+
+    /* the BURTC counter cannot be written, so store an offset instead */
+    uint32_t hw_counter = BURTC_CounterGet();
+    uint32_t offset = BURTC_RetRegGet(RTT_RET_OFFSET);
+    uint32_t new_offset = counter - hw_counter;
+
+    /* adding the offset carries into the upper 32 bits if the sum wraps.
+       Only the lower 32 bits are set, so compensate the overflow count for
+       a change of that carry (e.g. a borrow if the counter is set below the
+       BURTC counter) */
+    uint32_t carry = ((uint32_t) (hw_counter + offset) < hw_counter);
+    uint32_t new_carry = (counter < hw_counter);
+
+    BURTC_RetRegSet(RTT_RET_OVERFLOWS,
+                    BURTC_RetRegGet(RTT_RET_OVERFLOWS) + carry - new_carry);
+    BURTC_RetRegSet(RTT_RET_OFFSET, new_offset);
+
+    irq_restore(cpsr);
+}
+
+void rtt_set_alarm(uint32_t alarm, rtt_cb_t cb, void *arg)
+{
+    rtt_state.alarm_cb = cb;
+    rtt_state.alarm_arg = arg;
+
+    /* disable interrupt so it doesn't accidentally trigger */
+    BURTC_IntDisable(BURTC_IEN_COMP0);
+
+    /* set compare register */
+    BURTC_CompareSet(0, alarm - BURTC_RetRegGet(RTT_RET_OFFSET));
+
+    /* enable the interrupt */
+    BURTC_IntClear(BURTC_IFC_COMP0);
+    BURTC_IntEnable(BURTC_IEN_COMP0);
+}
+
+uint32_t rtt_get_alarm(void)
+{
+    return BURTC_CompareGet(0) + BURTC_RetRegGet(RTT_RET_OFFSET);
+}
+
+void rtt_clear_alarm(void)
+{
+    rtt_state.alarm_cb = NULL;
+    rtt_state.alarm_arg = NULL;
+
+    /* disable the interrupt */
+    BURTC_IntDisable(BURTC_IEN_COMP0);
+}
+
+void rtt_poweron(void)
+{
+    /* the BURTC is part of the backup domain, and keeps running */
+}
+
+void rtt_poweroff(void)
+{
+    /* stopping the BURTC would reset the counter, which is not desired */
+}
+
+void isr_burtc(void)
+{
+    if ((BURTC_IntGet() & BURTC_IF_COMP0)) {
+        if (rtt_state.alarm_cb != NULL) {
+            rtt_state.alarm_cb(rtt_state.alarm_arg);
+        }
+
+        /* clear interrupt */
+        BURTC_IntClear(BURTC_IFC_COMP0);
+    }
+    if (BURTC_IntGet() & BURTC_IF_OF) {
+        /* clear interrupt first, so rtt_get_counter64 does not count this
+           overflow twice */
+        BURTC_IntClear(BURTC_IFC_OF);
+
+        BURTC_RetRegSet(RTT_RET_OVERFLOWS,
+                        BURTC_RetRegGet(RTT_RET_OVERFLOWS) + 1);
+
+        if (rtt_state.overflow_cb != NULL) {
+            rtt_state.overflow_cb(rtt_state.overflow_arg);
+        }
+    }
+    cortexm_isr_end();
+}
+
+#endif /* defined(BURTC_COUNT) && BURTC_COUNT > 0 && BURTC_ENABLED */
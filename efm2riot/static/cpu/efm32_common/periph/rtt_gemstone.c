@@ -23,42 +23,90 @@
 #include "periph_conf.h"
 #include "periph/rtt.h"
 
+#include "clk.h"
+
+#ifdef MODULE_PM_LAYERED
+#include "pm_layered.h"
+#endif
+
 #include "em_cmu.h"
 #include "em_rtcc.h"
 #include "em_common_utils.h"
 
 #if defined(RTCC_COUNT) && RTCC_COUNT > 0
 
+/**
+ * @brief   Prescaler of the 32768 Hz low-frequency clock, to achieve the
+ *          configured RTT frequency.
+ */
+#define RTT_PRESCALER       (32768U / RTT_FREQUENCY)
+
+#if (RTT_FREQUENCY > 32768U) || (RTT_PRESCALER & (RTT_PRESCALER - 1)) != 0
+#error "RTT_FREQUENCY must be a power of two, up to 32768 Hz."
+#endif
+
 typedef struct {
     rtt_cb_t alarm_cb;              /**< callback called from RTC alarm */
     void *alarm_arg;                /**< argument passed to the callback */
     rtt_cb_t overflow_cb;           /**< callback called when RTC overflows */
     void *overflow_arg;             /**< argument passed to the callback */
+    volatile uint32_t overflows;    /**< number of counter overflows */
+    rtt_alarm_t *alarms;            /**< sorted list of software alarms */
 } rtt_state_t;
 
 static rtt_state_t rtt_state;
 
+/**
+ * @brief   Acquire the clock, and block EM3, in which the low-frequency clocks
+ *          stop, while the RTT is powered.
+ */
+static void _powered(bool powered)
+{
+    static bool acquired;
+
+    if (acquired == powered) {
+        return;
+    }
+
+    if (powered) {
+        clk_acquire(cmuClock_RTCC);
+#ifdef MODULE_PM_LAYERED
+        pm_block(EFM32_PM_MODE_EM3);
+#endif
+    }
+    else {
+#ifdef MODULE_PM_LAYERED
+        pm_unblock(EFM32_PM_MODE_EM3);
+#endif
+        clk_release(cmuClock_RTCC);
+    }
+
+    acquired = powered;
+}
+
 void rtt_init(void)
 {
     /* enable clocks */
-    CMU_ClockEnable(cmuClock_CORELE, true);
-    CMU_ClockEnable(cmuClock_RTCC, true);
+    _powered(true);
 
     /* reset and initialize peripheral */
     EFM32_CREATE_INIT(init, RTCC_Init_TypeDef, RTCC_INIT_DEFAULT,
         .conf.enable = false,
-        .conf.presc = rtccCntPresc_32768
+        .conf.presc = (RTCC_CntPresc_TypeDef) __builtin_ctz(RTT_PRESCALER)
     );
 
     RTCC_Reset();
     RTCC_Init(&init.conf);
 
-    /* initialize alarm channel */
+    /* initialize alarm channel, and the channel for software alarms */
     RTCC_CCChConf_TypeDef init_channel = RTCC_CH_INIT_COMPARE_DEFAULT;
 
     RTCC_ChannelInit(0, &init_channel);
+    RTCC_ChannelInit(1, &init_channel);
+
+    /* enable interrupts (overflows are always counted) */
+    RTCC_IntEnable(RTCC_IEN_OF);
 
-    /* enable interrupts */
     NVIC_ClearPendingIRQ(RTCC_IRQn);
     NVIC_EnableIRQ(RTCC_IRQn);
 
@@ -70,17 +118,12 @@ void rtt_set_overflow_cb(rtt_cb_t cb, void *arg)
 {
     rtt_state.overflow_cb = cb;
     rtt_state.overflow_arg = arg;
-
-    RTCC_IntClear(RTCC_IFC_OF);
-    RTCC_IntEnable(RTCC_IEN_OF);
 }
 
 void rtt_clear_overflow_cb(void)
 {
     rtt_state.overflow_cb = NULL;
     rtt_state.overflow_arg = NULL;
-
-    RTCC_IntDisable(RTCC_IEN_OF);
 }
 
 uint32_t rtt_get_counter(void)
@@ -88,6 +131,28 @@ uint32_t rtt_get_counter(void)
     return RTCC_CounterGet();
 }
 
+uint64_t rtt_get_counter64(void)
+{
+    uint32_t overflows;
+    uint32_t counter;
+    bool pending;
+
+    /* retry if an overflow was handled in between */
+    do {
+        overflows = rtt_state.overflows;
+        counter = RTCC_CounterGet();
+        pending = (RTCC_IntGet() & RTCC_IF_OF) != 0;
+    } while (overflows != rtt_state.overflows);
+
+    /* account for an overflow that is not handled yet (e.g. interrupts are
+       disabled), if the counter wrapped before it was read */
+    if (pending && counter < (RTT_MAX_VALUE >> 1)) {
+        overflows++;
+    }
+
+    return ((uint64_t) overflows << 32) + counter;
+}
+
 void rtt_set_counter(uint32_t counter)
 {
     RTCC->CNT = counter & RTT_MAX_VALUE;
@@ -123,14 +188,121 @@ void rtt_clear_alarm(void)
     RTCC_IntDisable(RTCC_IEN_CC0);
 }
 
+/**
+ * @brief   Program the compare channel for the first alarm in the list.
+ *
+ * Must be called with interrupts disabled.
+ */
+static void _alarm_program(void)
+{
+    rtt_alarm_t *head = rtt_state.alarms;
+
+    /* disable interrupt so it doesn't accidentally trigger */
+    RTCC_IntDisable(RTCC_IEN_CC1);
+
+    if (head == NULL) {
+        return;
+    }
+
+    RTCC_ChannelCCVSet(1, head->target & RTT_MAX_VALUE);
+    RTCC_IntClear(RTCC_IFC_CC1);
+    RTCC_IntEnable(RTCC_IEN_CC1);
+
+    /* the deadline may have passed while programming, so trigger the
+       interrupt manually */
+    if (head->target <= rtt_get_counter64()) {
+        RTCC_IntSet(RTCC_IFS_CC1);
+    }
+}
+
+void rtt_alarm_add(rtt_alarm_t *alarm, uint64_t target,
+                   void (*cb)(void *arg), void *arg)
+{
+    unsigned int cpsr = irq_disable();
+
+    alarm->target = target;
+    alarm->cb = cb;
+    alarm->arg = arg;
+
+    /* insert sorted, after alarms with the same deadline */
+    rtt_alarm_t **node = &rtt_state.alarms;
+
+    while (*node != NULL && (*node)->target <= target) {
+        node = &(*node)->next;
+    }
+
+    alarm->next = *node;
+    *node = alarm;
+
+    /* only reprogram if the first alarm changed */
+    if (rtt_state.alarms == alarm) {
+        _alarm_program();
+    }
+
+    irq_restore(cpsr);
+}
+
+void rtt_alarm_remove(rtt_alarm_t *alarm)
+{
+    unsigned int cpsr = irq_disable();
+
+    rtt_alarm_t **node = &rtt_state.alarms;
+
+    while (*node != NULL && *node != alarm) {
+        node = &(*node)->next;
+    }
+
+    if (*node != NULL) {
+        bool head = (node == &rtt_state.alarms);
+
+        *node = alarm->next;
+
+        if (head) {
+            _alarm_program();
+        }
+    }
+
+    irq_restore(cpsr);
+}
+
+/**
+ * @brief   Run all expired alarms, and program the next one.
+ */
+static void _alarm_expire(void)
+{
+    uint64_t now = rtt_get_counter64();
+
+    while (1) {
+        /* unlink with interrupts disabled, since a higher priority interrupt
+           may add or remove an alarm */
+        unsigned int cpsr = irq_disable();
+        rtt_alarm_t *alarm = rtt_state.alarms;
+
+        if (alarm == NULL || alarm->target > now) {
+            irq_restore(cpsr);
+            break;
+        }
+
+        rtt_state.alarms = alarm->next;
+        irq_restore(cpsr);
+
+        /* the callback may add this alarm again */
+        alarm->cb(alarm->arg);
+    }
+
+    unsigned int cpsr = irq_disable();
+    _alarm_program();
+    irq_restore(cpsr);
+}
+
 void rtt_poweron(void)
 {
-    CMU_ClockEnable(cmuClock_RTCC, true);
+    _powered(true);
 }
 
 void rtt_poweroff(void)
 {
-    CMU_ClockEnable(cmuClock_RTCC, false);
+    _powered(false);
 }
 
 void isr_rtcc(void)
@@ -143,13 +315,22 @@ void isr_rtcc(void)
         /* clear interrupt */
         RTCC_IntClear(RTCC_IFC_CC0);
     }
+    if (RTCC_IntGet() & RTCC_IF_CC1) {
+        /* clear interrupt */
+        RTCC_IntClear(RTCC_IFC_CC1);
+
+        _alarm_expire();
+    }
     if (RTCC_IntGet() & RTCC_IF_OF) {
+        /* clear interrupt first, so rtt_get_counter64 does not count this
+           overflow twice */
+        RTCC_IntClear(RTCC_IFC_OF);
+
+        rtt_state.overflows++;
+
         if (rtt_state.overflow_cb != NULL) {
             rtt_state.overflow_cb(rtt_state.overflow_arg);
         }
-
-        /* clear interrupt */
-        RTCC_IntClear(RTCC_IFC_OF);
     }
     cortexm_isr_end();
 }
@@ -29,6 +29,12 @@
 #include "periph/gpio.h"
 #include "periph/spi.h"
 
+#include "clk.h"
+
+#ifdef MODULE_PM_LAYERED
+#include "pm_layered.h"
+#endif
+
 #include "em_device.h"
 #include "em_cmu.h"
 #include "em_usart.h"
@@ -46,6 +52,34 @@ static mutex_t spi_lock[SPI_NUMOF] = {
 #endif
 };
 
+/**
+ * @brief   Bus speed of each initialized device
+ */
+static uint32_t spi_speed[SPI_NUMOF];
+
+/**
+ * @brief   Notifier, to update the bus speeds when the HF clock changes
+ */
+static clk_notifier_t spi_notifier;
+
+/**
+ * @brief   Recompute the clock dividers from the new HF clock.
+ */
+static void _clk_changed(void *arg)
+{
+    (void) arg;
+
+    for (spi_t dev = 0; dev < SPI_NUMOF; dev++) {
+        if (spi_speed[dev] == 0) {
+            continue;
+        }
+
+        clk_acquire(spi_config[dev].cmu);
+        USART_BaudrateSyncSet(spi_config[dev].dev, 0, spi_speed[dev]);
+        clk_release(spi_config[dev].cmu);
+    }
+}
+
 int spi_init_master(spi_t dev, spi_conf_t conf, spi_speed_t speed)
 {
     /* check if device is valid */
@@ -53,9 +87,16 @@ int spi_init_master(spi_t dev, spi_conf_t conf, spi_speed_t speed)
         return -1;
     }
 
-    /* enable clocks */
-    CMU_ClockEnable(cmuClock_HFPER, true);
-    CMU_ClockEnable(spi_config[dev].cmu, true);
+    /* the clock divider is computed from the HFXO frequency */
+    pm_hfxo_wait();
+
+    /* and updated when the HF clock changes */
+    spi_speed[dev] = (uint32_t) speed;
+    clk_notifier_add(&spi_notifier, _clk_changed, NULL);
+
+    /* the clock is only enabled while configuring, and during a transaction
+       (see spi_acquire), the configuration is retained in between */
+    clk_acquire(spi_config[dev].cmu);
 
     /* initialize and enable peripheral */
     EFM32_CREATE_INIT(init, USART_InitSync_TypeDef, USART_INITSYNC_DEFAULT,
@@ -69,6 +110,8 @@ int spi_init_master(spi_t dev, spi_conf_t conf, spi_speed_t speed)
     /* configure the pins */
     spi_conf_pins(dev);
 
+    clk_release(spi_config[dev].cmu);
+
     return 0;
 }
 
@@ -89,6 +132,8 @@ int spi_conf_pins(spi_t dev)
     gpio_set(spi_config[dev].mosi_pin);
 
     /* configure pin functions */
+    clk_acquire(spi_config[dev].cmu);
+
 #ifdef _SILICON_LABS_32B_PLATFORM_1
     spi_config[dev].dev->ROUTE = (spi_config[dev].loc |
                                   USART_ROUTE_RXPEN |
@@ -101,6 +146,8 @@ int spi_conf_pins(spi_t dev)
                                      USART_ROUTEPEN_CLKPEN);
 #endif
 
+    clk_release(spi_config[dev].cmu);
+
     return 0;
 }
 
@@ -108,11 +155,24 @@ int spi_acquire(spi_t dev)
 {
     mutex_lock((mutex_t *) &spi_lock[dev]);
 
+    clk_acquire(spi_config[dev].cmu);
+
+#ifdef MODULE_PM_LAYERED
+    /* the peripheral needs the high-frequency clock during a transaction */
+    pm_block(EFM32_PM_MODE_EM2);
+#endif
+
     return 0;
 }
 
 int spi_release(spi_t dev)
 {
+#ifdef MODULE_PM_LAYERED
+    pm_unblock(EFM32_PM_MODE_EM2);
+#endif
+
+    clk_release(spi_config[dev].cmu);
+
     mutex_unlock((mutex_t *) &spi_lock[dev]);
 
     return 0;
@@ -137,12 +197,12 @@ void spi_transmission_begin(spi_t dev, char reset_val)
 
 void spi_poweron(spi_t dev)
 {
-    CMU_ClockEnable(spi_config[dev].cmu, true);
+    /* the clock is enabled during a transaction only (see spi_acquire) */
 }
 
 void spi_poweroff(spi_t dev)
 {
-    CMU_ClockEnable(spi_config[dev].cmu, false);
+    /* the clock is gated outside of a transaction (see spi_release) */
 }
 
 #endif /* SPI_NUMOF */
@@ -0,0 +1,147 @@
+/*
+ * Copyright (C) 2017 Bas Stottelaar <basstottelaar@gmail.com>
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     cpu_efm32_common
+ * @{
+ *
+ * @file
+ * @brief       Low-level stream pacer implementation (TIMER overflow routed
+ *              to a PRS channel)
+ *
+ * @author      Bas Stottelaar <basstottelaar@gmail.com>
+ *
+ * @}
+ */
+
+#include "cpu.h"
+
+#include "periph_conf.h"
+
+#include "clk.h"
+
+#ifdef MODULE_PM_LAYERED
+#include "pm_layered.h"
+#endif
+
+#include "em_cmu.h"
+#include "em_prs.h"
+#include "em_timer.h"
+
+/**
+ * @brief   Largest prescaler supported by the TIMER (2^10 = 1024).
+ */
+#define STREAM_MAX_PRESCALER    (10U)
+
+/**
+ * @brief   Acquire (or release) the clocks of a running timer.
+ */
+static void _clocks(const stream_conf_t *conf, bool acquire)
+{
+    if (acquire) {
+        clk_acquire(cmuClock_PRS);
+        clk_acquire(conf->cmu);
+    }
+    else {
+        clk_release(conf->cmu);
+        clk_release(cmuClock_PRS);
+    }
+}
+
+/**
+ * @brief   Check if a timer is running (and holds its clocks).
+ */
+static bool _running(const stream_conf_t *conf)
+{
+    clk_acquire(conf->cmu);
+    bool running = (conf->dev->STATUS & TIMER_STATUS_RUNNING) != 0;
+    clk_release(conf->cmu);
+
+    return running;
+}
+
+int stream_timer_start(const stream_conf_t *conf, uint32_t rate)
+{
+    uint32_t div = 0;
+
+    /* the sample rate is derived from the HFXO frequency */
+    pm_hfxo_wait();
+
+    /* a restarted timer already holds its clocks, and blocks EM2 */
+    bool running = _running(conf);
+
+    if (!running) {
+        _clocks(conf, true);
+    }
+
+    /* find the smallest prescaler that fits the top value in 16 bits */
+    uint32_t freq = CMU_ClockFreqGet(conf->cmu);
+
+    if (rate == 0 || rate > freq) {
+        if (!running) {
+            _clocks(conf, false);
+        }
+
+        return -1;
+    }
+
+    while (((freq >> div) / rate) > 0x10000) {
+        div++;
+    }
+
+    if (div > STREAM_MAX_PRESCALER) {
+        if (!running) {
+            _clocks(conf, false);
+        }
+
+        return -1;
+    }
+
+    /* configure the timer, but do not start it yet */
+    TIMER_Init_TypeDef init = TIMER_INIT_DEFAULT;
+
+    init.enable = false;
+    init.prescale = (TIMER_Prescale_TypeDef) div;
+
+    TIMER_Reset(conf->dev);
+    TIMER_Init(conf->dev, &init);
+    TIMER_TopSet(conf->dev, ((freq >> div) / rate) - 1);
+
+    /* route the overflow to the PRS channel, as a pulse */
+    PRS_SourceSignalSet(conf->prs_channel, conf->prs_source,
+                        PRS_CH_CTRL_SIGSEL_TIMER0OF, prsEdgeOff);
+
+    TIMER_Enable(conf->dev, true);
+
+#ifdef MODULE_PM_LAYERED
+    /* the timer (and the peripherals it paces) stops in EM2 */
+    if (!running) {
+        pm_block(EFM32_PM_MODE_EM2);
+    }
+#endif
+
+    return 0;
+}
+
+void stream_timer_stop(const stream_conf_t *conf)
+{
+    /* a stopped timer does not hold its clocks anymore */
+    if (!_running(conf)) {
+        return;
+    }
+
+#ifdef MODULE_PM_LAYERED
+    pm_unblock(EFM32_PM_MODE_EM2);
+#endif
+
+    TIMER_Enable(conf->dev, false);
+
+    PRS_SourceSignalSet(conf->prs_channel, 0, 0, prsEdgeOff);
+
+    _clocks(conf, false);
+}
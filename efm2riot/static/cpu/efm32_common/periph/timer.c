@@ -25,9 +25,14 @@
 #include "periph/timer.h"
 #include "periph_conf.h"
 
+#include "clk.h"
+
+#ifdef MODULE_PM_LAYERED
+#include "pm_layered.h"
+#endif
+
 #include "em_cmu.h"
 #include "em_timer.h"
-#include "em_timer_utils.h"
 #include "em_common_utils.h"
 
 /**
@@ -40,6 +45,88 @@
  */
 static timer_isr_ctx_t isr_ctx[TIMER_NUMOF];
 
+/**
+ * @brief   Track if the clock of a timer is acquired
+ */
+static bool timer_clocked[TIMER_NUMOF];
+
+/**
+ * @brief   Track if a timer is running (and blocks a power mode)
+ */
+static bool timer_running[TIMER_NUMOF];
+
+/**
+ * @brief   Frequency of each initialized timer
+ */
+static unsigned long timer_freq[TIMER_NUMOF];
+
+/**
+ * @brief   Notifier, to update the prescalers when the HF clock changes
+ */
+static clk_notifier_t timer_notifier;
+
+/**
+ * @brief   Compute the top value of the prescaler timer, which divides the
+ *          HF peripheral clock down to the timer frequency.
+ */
+static uint32_t _prescaler_top(tim_t dev)
+{
+    uint32_t freq_timer = CMU_ClockFreqGet(timer_config[dev].prescaler.cmu);
+
+    return (freq_timer / timer_freq[dev]) - 1;
+}
+
+/**
+ * @brief   Update the prescaler top values from the new HF clock.
+ */
+static void _clk_changed(void *arg)
+{
+    (void) arg;
+
+    for (tim_t dev = 0; dev < TIMER_NUMOF; dev++) {
+        if (timer_freq[dev] == 0) {
+            continue;
+        }
+
+        TIMER_TypeDef *pre = timer_config[dev].prescaler.dev;
+
+        /* restart the prescaler period, which may be beyond the new top */
+        clk_acquire(timer_config[dev].prescaler.cmu);
+        TIMER_TopSet(pre, _prescaler_top(dev));
+        TIMER_CounterSet(pre, 0);
+        clk_release(timer_config[dev].prescaler.cmu);
+    }
+}
+
+/**
+ * @brief   Clock the prescaler, and block EM2, in which the timer stops, while
+ *          the timer is running.
+ *
+ * The timer itself stays clocked, so its registers can be accessed while it
+ * is stopped.
+ */
+static void _running(tim_t dev, bool running)
+{
+    if (timer_running[dev] == running) {
+        return;
+    }
+
+    if (running) {
+        clk_acquire(timer_config[dev].prescaler.cmu);
+#ifdef MODULE_PM_LAYERED
+        pm_block(EFM32_PM_MODE_EM2);
+#endif
+    }
+    else {
+#ifdef MODULE_PM_LAYERED
+        pm_unblock(EFM32_PM_MODE_EM2);
+#endif
+        clk_release(timer_config[dev].prescaler.cmu);
+    }
+
+    timer_running[dev] = running;
+}
+
 int timer_init(tim_t dev, unsigned long freq, timer_cb_t callback, void *arg)
 {
     TIMER_TypeDef *pre, *tim;
@@ -56,10 +143,20 @@ int timer_init(tim_t dev, unsigned long freq, timer_cb_t callback, void *arg)
     pre = timer_config[dev].prescaler.dev;
     tim = timer_config[dev].timer.dev;
 
+    /* the prescaler top value is computed from the HFXO frequency */
+    pm_hfxo_wait();
+
+    /* and updated when the HF clock changes */
+    timer_freq[dev] = freq;
+    clk_notifier_add(&timer_notifier, _clk_changed, NULL);
+
     /* enable clocks */
-    CMU_ClockEnable(cmuClock_HFPER, true);
-    CMU_ClockEnable(timer_config[dev].prescaler.cmu, true);
-    CMU_ClockEnable(timer_config[dev].timer.cmu, true);
+    if (!timer_clocked[dev]) {
+        clk_acquire(timer_config[dev].timer.cmu);
+        timer_clocked[dev] = true;
+    }
+
+    _running(dev, true);
 
     /* reset and initialize peripherals */
     EFM32_CREATE_INIT(init_pre, TIMER_Init_TypeDef, TIMER_INIT_DEFAULT,
@@ -78,11 +175,7 @@ int timer_init(tim_t dev, unsigned long freq, timer_cb_t callback, void *arg)
     TIMER_Init(pre, &init_pre.conf);
 
     /* configure the prescaler top value */
-    uint32_t freq_timer = CMU_ClockFreqGet(timer_config[dev].prescaler.cmu);
-    uint32_t top = (
-        freq_timer / TIMER_Prescaler2Div(init_pre.conf.prescale) / freq) - 1;
-
-    TIMER_TopSet(pre, top);
+    TIMER_TopSet(pre, _prescaler_top(dev));
     TIMER_TopSet(tim, 0xffff);
 
     /* enable interrupts for the channels */
@@ -137,10 +230,17 @@ unsigned int timer_read(tim_t dev)
 void timer_stop(tim_t dev)
 {
     TIMER_Enable(timer_config[dev].timer.dev, false);
+
+    _running(dev, false);
 }
 
 void timer_start(tim_t dev)
 {
+    /* do not count at the HFRCO frequency, after waking up */
+    pm_hfxo_wait();
+
+    _running(dev, true);
+
     TIMER_Enable(timer_config[dev].timer.dev, true);
 }
 
@@ -150,7 +250,7 @@ void timer_reset(tim_t dev)
 }
 
 #ifdef TIMER_0_ISR
-void TIMER_0_ISR(void)
+EFM32_RAMFUNC void TIMER_0_ISR(void)
 {
     TIMER_TypeDef *tim = timer_config[0].timer.dev;
 
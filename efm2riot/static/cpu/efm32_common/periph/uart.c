@@ -25,6 +25,12 @@
 #include "periph/uart.h"
 #include "periph/gpio.h"
 
+#include "clk.h"
+
+#ifdef MODULE_PM_LAYERED
+#include "pm_layered.h"
+#endif
+
 #include "em_usart.h"
 #if LOW_POWER_ENABLED && defined(LEUART_COUNT) && LEUART_COUNT > 0
 #include "em_leuart.h"
@@ -36,6 +42,22 @@
  */
 static uart_isr_ctx_t isr_ctx[UART_NUMOF];
 
+/**
+ * @brief   Track if a device is clocked (and blocks a power mode), to receive
+ *          data
+ */
+static bool rx_active[UART_NUMOF];
+
+/**
+ * @brief   Baud rate of each initialized device
+ */
+static uint32_t uart_baudrate[UART_NUMOF];
+
+/**
+ * @brief   Notifier, to update the baud rates when the HF clock changes
+ */
+static clk_notifier_t uart_notifier;
+
 /**
  * @brief   Check if device is a U(S)ART device.
  */
@@ -44,6 +66,73 @@ static inline bool _is_usart(uart_t dev)
     return ((uint32_t) uart_config[dev].dev) < LEUART0_BASE;
 }
 
+#ifdef MODULE_PM_LAYERED
+/**
+ * @brief   Get the power mode in which a device stops operating.
+ *
+ * The U(S)ART needs the high-frequency clock, but the LEUART runs in EM2.
+ */
+static inline unsigned _pm_mode(uart_t dev)
+{
+    return _is_usart(dev) ? EFM32_PM_MODE_EM2 : EFM32_PM_MODE_EM3;
+}
+#endif
+
+/**
+ * @brief   Keep a device clocked, and block the power mode in which it stops
+ *          operating, as long as it can receive data.
+ */
+static void _rx(uart_t dev, bool active)
+{
+    if (isr_ctx[dev].rx_cb == NULL || rx_active[dev] == active) {
+        return;
+    }
+
+    if (active) {
+        clk_acquire(uart_config[dev].cmu);
+#ifdef MODULE_PM_LAYERED
+        pm_block(_pm_mode(dev));
+#endif
+    }
+    else {
+#ifdef MODULE_PM_LAYERED
+        pm_unblock(_pm_mode(dev));
+#endif
+        clk_release(uart_config[dev].cmu);
+    }
+
+    rx_active[dev] = active;
+}
+
+/**
+ * @brief   Recompute the baud rate dividers from the new HF clock.
+ */
+static void _clk_changed(void *arg)
+{
+    (void) arg;
+
+    for (uart_t dev = 0; dev < UART_NUMOF; dev++) {
+        if (uart_baudrate[dev] == 0) {
+            continue;
+        }
+
+        clk_acquire(uart_config[dev].cmu);
+
+#if LOW_POWER_ENABLED && defined(LEUART_COUNT) && LEUART_COUNT > 0
+        if (_is_usart(dev)) {
+#endif
+            USART_BaudrateAsyncSet(uart_config[dev].dev, 0,
+                                   uart_baudrate[dev], usartOVS16);
+#if LOW_POWER_ENABLED && defined(LEUART_COUNT) && LEUART_COUNT > 0
+        } else {
+            LEUART_BaudrateSet(uart_config[dev].dev, 0, uart_baudrate[dev]);
+        }
+#endif
+
+        clk_release(uart_config[dev].cmu);
+    }
+}
+
 int uart_init(uart_t dev, uint32_t baudrate, uart_rx_cb_t rx_cb, void *arg)
 {
     /* check if device is valid */
@@ -51,7 +140,9 @@ int uart_init(uart_t dev, uint32_t baudrate, uart_rx_cb_t rx_cb, void *arg)
         return -1;
     }
 
-    /* save interrupt callback context */
+    /* save interrupt callback context (after releasing a previous one) */
+    _rx(dev, false);
+
     isr_ctx[dev].rx_cb = rx_cb;
     isr_ctx[dev].arg = arg;
 
@@ -59,16 +150,23 @@ int uart_init(uart_t dev, uint32_t baudrate, uart_rx_cb_t rx_cb, void *arg)
     gpio_init(uart_config[dev].rx_pin, GPIO_IN);
     gpio_init(uart_config[dev].tx_pin, GPIO_OUT);
 
+    /* the baud rate divider depends on the HF clock, if it is restarting */
+    pm_hfxo_wait();
+
+    /* update the divider if the HF clock changes later on */
+    uart_baudrate[dev] = baudrate;
+    clk_notifier_add(&uart_notifier, _clk_changed, NULL);
+
+    /* the clock is enabled while configuring, and while the device can
+       receive or is writing data */
+    clk_acquire(uart_config[dev].cmu);
+
     /* initialize the UART/USART/LEUART device */
 #if LOW_POWER_ENABLED && defined(LEUART_COUNT) && LEUART_COUNT > 0
     if (_is_usart(dev)) {
 #endif
         USART_TypeDef *uart = (USART_TypeDef *) uart_config[dev].dev;
 
-        /* enable clocks */
-        CMU_ClockEnable(cmuClock_HFPER, true);
-        CMU_ClockEnable(uart_config[dev].cmu, true);
-
         /* reset and initialize peripheral */
         EFM32_CREATE_INIT(init, USART_InitAsync_TypeDef, USART_INITASYNC_DEFAULT,
             .conf.enable = usartDisable,
@@ -96,10 +194,6 @@ int uart_init(uart_t dev, uint32_t baudrate, uart_rx_cb_t rx_cb, void *arg)
     } else {
         LEUART_TypeDef *leuart = (LEUART_TypeDef *) uart_config[dev].dev;
 
-        /* enable clocks */
-        CMU_ClockEnable(cmuClock_CORELE, true);
-        CMU_ClockEnable(uart_config[dev].cmu, true);
-
         /* reset and initialize peripheral */
         EFM32_CREATE_INIT(init, LEUART_Init_TypeDef, LEUART_INIT_DEFAULT,
             .conf.enable = leuartDisable,
@@ -130,37 +224,67 @@ int uart_init(uart_t dev, uint32_t baudrate, uart_rx_cb_t rx_cb, void *arg)
     NVIC_ClearPendingIRQ(uart_config[dev].irq);
     NVIC_EnableIRQ(uart_config[dev].irq);
 
+    /* stay clocked, in a power mode in which data can be received */
+    _rx(dev, true);
+
+    clk_release(uart_config[dev].cmu);
+
     return 0;
 }
 
 void uart_write(uart_t dev, const uint8_t *data, size_t len)
 {
+    /* the baud rate is only correct once the HFXO is selected again */
+    pm_hfxo_wait();
+
+    clk_acquire(uart_config[dev].cmu);
+
+#ifdef MODULE_PM_LAYERED
+    pm_block(_pm_mode(dev));
+#endif
+
 #if LOW_POWER_ENABLED && defined(LEUART_COUNT) && LEUART_COUNT > 0
     if (_is_usart(dev)) {
 #endif
+        USART_TypeDef *uart = (USART_TypeDef *) uart_config[dev].dev;
+
         while (len--) {
-            USART_Tx(uart_config[dev].dev, *(data++));
+            USART_Tx(uart, *(data++));
         }
+
+        /* wait until the last byte has left the shift register */
+        while (!(uart->STATUS & USART_STATUS_TXC)) {}
 #if LOW_POWER_ENABLED && defined(LEUART_COUNT) && LEUART_COUNT > 0
     } else {
+        LEUART_TypeDef *leuart = (LEUART_TypeDef *) uart_config[dev].dev;
+
         while (len--) {
-            LEUART_Tx(uart_config[dev].dev, *(data++));
+            LEUART_Tx(leuart, *(data++));
         }
+
+        /* wait until the last byte has left the shift register */
+        while (!(leuart->STATUS & LEUART_STATUS_TXC)) {}
     }
 #endif
+
+#ifdef MODULE_PM_LAYERED
+    pm_unblock(_pm_mode(dev));
+#endif
+
+    clk_release(uart_config[dev].cmu);
 }
 
 void uart_poweron(uart_t dev)
 {
-    CMU_ClockEnable(uart_config[dev].cmu, true);
+    _rx(dev, true);
 }
 
 void uart_poweroff(uart_t dev)
 {
-    CMU_ClockEnable(uart_config[dev].cmu, false);
+    _rx(dev, false);
 }
 
-static void rx_irq(uart_t dev)
+static EFM32_RAMFUNC void rx_irq(uart_t dev)
 {
 #if LOW_POWER_ENABLED && defined(LEUART_COUNT) && LEUART_COUNT > 0
     if (_is_usart(dev)) {
@@ -179,35 +303,35 @@ static void rx_irq(uart_t dev)
 }
 
 #ifdef UART_0_ISR_RX
-void UART_0_ISR_RX(void)
+EFM32_RAMFUNC void UART_0_ISR_RX(void)
 {
     rx_irq(0);
 }
 #endif
 
 #ifdef UART_1_ISR_RX
-void UART_1_ISR_RX(void)
+EFM32_RAMFUNC void UART_1_ISR_RX(void)
 {
     rx_irq(1);
 }
 #endif
 
 #ifdef UART_2_ISR_RX
-void UART_2_ISR_RX(void)
+EFM32_RAMFUNC void UART_2_ISR_RX(void)
 {
     rx_irq(2);
 }
 #endif
 
 #ifdef UART_3_ISR_RX
-void UART_3_ISR_RX(void)
+EFM32_RAMFUNC void UART_3_ISR_RX(void)
 {
     rx_irq(3);
 }
 #endif
 
 #ifdef UART_4_ISR_RX
-void UART_4_ISR_RX(void)
+EFM32_RAMFUNC void UART_4_ISR_RX(void)
 {
     rx_irq(4);
 }
@@ -19,6 +19,7 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 
 #include "cpu.h"
 #include "board.h"
@@ -26,6 +27,8 @@
 
 #include "periph/adc.h"
 
+#include "em_adc_utils.h"
+
 #define DELAY           (1000 * 1000U)
 
 int main(void)
@@ -37,27 +40,22 @@ int main(void)
     }
 
     /* factory calibration values */
-#ifdef _SILICON_LABS_32B_PLATFORM_1
-    float cal_temp = (float) ((DEVINFO->CAL & _DEVINFO_CAL_TEMP_MASK) >> _DEVINFO_CAL_TEMP_SHIFT);
-    float cal_value = (float) ((DEVINFO->ADC0CAL2 & _DEVINFO_ADC0CAL2_TEMP1V25_MASK) >> _DEVINFO_ADC0CAL2_TEMP1V25_SHIFT);
-#else
-    float cal_temp = (float) ((DEVINFO->CAL & _DEVINFO_CAL_TEMP_MASK) >> _DEVINFO_CAL_TEMP_SHIFT);
-    float cal_value = (float) ((DEVINFO->ADC0CAL3 & _DEVINFO_ADC0CAL3_TEMPREAD1V25_MASK) >> _DEVINFO_ADC0CAL3_TEMPREAD1V25_SHIFT);
-#endif
+    ADC_TempCal_TypeDef cal;
+
+    ADC_TempCalGet(&cal);
 
     while (1) {
         /* convert temperature channel */
         int32_t value = adc_sample(0, ADC_RES_12BIT);
 
-        /* convert sample to degrees Celsius, using the correction factors */
-#ifdef _SILICON_LABS_32B_PLATFORM_1
-        float temperature = cal_temp - ((cal_value - value) / -6.27);
-#else
-        float temperature = cal_temp - ((cal_value - value) / -6.01);
-#endif
+        /* convert sample to milli degrees Celsius, using the correction
+           factors */
+        int32_t temperature = ADC_Sample2MilliCelsius(&cal, value);
 
         /* print the results */
-        printf("Temperature: %.2f degrees celsius\n", temperature);
+        printf("Temperature: %s%ld.%02ld degrees celsius\n",
+               (temperature < 0) ? "-" : "", labs(temperature) / 1000,
+               (labs(temperature) % 1000) / 10);
 
         /* sleep a little while */
         xtimer_usleep(DELAY);
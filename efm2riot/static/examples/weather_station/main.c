@@ -20,6 +20,7 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 
 #include "board.h"
 #include "xtimer.h"
@@ -30,6 +31,8 @@
 #include "periph/gpio.h"
 #include "periph/adc.h"
 
+#include "em_adc_utils.h"
+
 #include "images.h"
 
 /**
@@ -51,22 +54,24 @@ static uint32_t pins_enabled = (
     (1 << U8X8_PIN_CS)
 );
 
-static float get_battery_voltage(void)
+/**
+ * @brief   Factory calibration of the internal temperature sensor.
+ */
+static ADC_TempCal_TypeDef temp_cal;
+
+static uint32_t get_battery_voltage(void)
 {
     int32_t value = adc_sample(1, ADC_RES_12BIT);
 
-    return (((float) value) / 4096.0) * 5.0;
+    return ADC_Sample2MilliVolt(value, 5000, 12);
 }
 
-static float get_internal_temp(void)
+static int32_t get_internal_temp(void)
 {
-    float cal_temp = (float) ((DEVINFO->CAL & _DEVINFO_CAL_TEMP_MASK) >> _DEVINFO_CAL_TEMP_SHIFT);
-    float cal_value = (float) ((DEVINFO->ADC0CAL3 & _DEVINFO_ADC0CAL3_TEMPREAD1V25_MASK) >> _DEVINFO_ADC0CAL3_TEMPREAD1V25_SHIFT);
-
     /* convert temperature channel */
     int32_t value = adc_sample(0, ADC_RES_12BIT);
 
-    return cal_temp - ((cal_value - value) / -6.01);
+    return ADC_Sample2MilliCelsius(&temp_cal, value);
 }
 
 int main(void)
@@ -78,6 +83,8 @@ int main(void)
     uint32_t timeout;
     int16_t temperature;
     uint16_t humidity;
+    int32_t internal_temp;
+    uint32_t battery_voltage;
 
     /* prepare display */
     gpio_init(DISP_COM_PIN, GPIO_OUT);
@@ -99,19 +106,25 @@ int main(void)
 
     si70xx_init(&dev, SI7021_I2C, SI70XX_ADDRESS_SI7021);
 
+    /* prepare adc (the configuration is retained during sleep) */
+    adc_init(0);
+    adc_init(1);
+
+    ADC_TempCalGet(&temp_cal);
+
     while (1) {
         /* measure temperature via Si7021 */
         si70xx_get_both(&dev, &humidity, &temperature);
 
-        /* wakeup/init adc */
-        adc_init(0);
-        adc_init(1);
+        /* measure internal temperature and battery voltage via ADC */
+        internal_temp = get_internal_temp();
+        battery_voltage = get_battery_voltage();
 
         /* display results */
         snprintf(buffer[0], 16, "%d.%02d %%", humidity / 100, humidity % 100);
         snprintf(buffer[1], 16, "%d.%02d C", temperature / 100, temperature % 100);
-        snprintf(buffer[2], 16, "%.2f C", get_internal_temp());
-        snprintf(buffer[3], 16, "%.2f V", get_battery_voltage());
+        snprintf(buffer[2], 16, "%s%ld.%02ld C", (internal_temp < 0) ? "-" : "", labs(internal_temp) / 1000, (labs(internal_temp) % 1000) / 10);
+        snprintf(buffer[3], 16, "%lu.%02lu V", battery_voltage / 1000, (battery_voltage % 1000) / 10);
         snprintf(buffer[4], 16, "%lu s", xtimer_now() / 1000);
 
         u8g2_FirstPage(&u8g2);
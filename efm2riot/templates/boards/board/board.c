@@ -32,6 +32,8 @@
 {% strip 3, ">" %}
     {% if board not in ["sltb001a"] %}
         {% if architecture not in ["m0", "m0plus"] %}
+            #include "clk.h"
+
             #include "em_dbg.h"
             #include "em_gpio.h"
         {% endif %}
@@ -89,7 +91,7 @@ void board_init(void)
                 #if AEM_ENABLED
                     if (DBG_Connected()) {
                         /* enable GPIO clock for configuring SWO pins */
-                        CMU_ClockEnable(cmuClock_GPIO, true);
+                        clk_acquire(cmuClock_GPIO);
 
                         /* enable debug peripheral via SWO */
                         {% strip 2 %}
@@ -160,30 +162,34 @@ void board_init(void)
                 board_pic_init();
             #endif
             
-                /* enable the CCS811 air quality/gas sensor */
+                /* the GPIO expander keeps its state when the MCU is in EM4, so
+                   reconfiguring it is only needed after a cold boot */
+                if (!cpu_woke_from_em4()) {
+                    /* enable the CCS811 air quality/gas sensor */
             #if CCS811_ENABLED
-                board_pic_write(CCS811_PIC_ADDR, (1 << CCS811_PIC_EN_BIT) | (1 << CCS811_PIC_WAKE_BIT));
+                    board_pic_write(CCS811_PIC_ADDR, (1 << CCS811_PIC_EN_BIT) | (1 << CCS811_PIC_WAKE_BIT));
             #endif
             
-                /* enable the IMU sensor */
+                    /* enable the IMU sensor */
             #if ICM_20648_ENABLED
-                board_pic_write(ICM20648_PIC_ADDR, 1 << ICM20648_PIC_EN_BIT);
+                    board_pic_write(ICM20648_PIC_ADDR, 1 << ICM20648_PIC_EN_BIT);
             #endif
             
-                /* enable the environmental sensors */
+                    /* enable the environmental sensors */
             #if BMP280_ENABLED || SI1133_ENABLED || SI7021_ENABLED || SI7210A_ENABLED
-                board_pic_write(ENV_SENSE_PIC_ADDR, 1 << ENV_SENSE_PIC_BIT);
+                    board_pic_write(ENV_SENSE_PIC_ADDR, 1 << ENV_SENSE_PIC_BIT);
             #endif
             
-                /* enable the RGB leds */
+                    /* enable the RGB leds */
             #if RGB_LED1_ENABLED || RGB_LED2_ENABLED || RGB_LED3_ENABLED || RGB_LED4_ENABLED
-                board_pic_write(RGB_LED_ADDR, 
-                    (1 << RGB_LED_EN_BIT) | 
-                    (RGB_LED1_ENABLED << RGB_LED1_EN_BIT) | 
-                    (RGB_LED2_ENABLED << RGB_LED2_EN_BIT) | 
-                    (RGB_LED3_ENABLED << RGB_LED3_EN_BIT) | 
-                    (RGB_LED4_ENABLED << RGB_LED4_EN_BIT));
+                    board_pic_write(RGB_LED_ADDR, 
+                        (1 << RGB_LED_EN_BIT) | 
+                        (RGB_LED1_ENABLED << RGB_LED1_EN_BIT) | 
+                        (RGB_LED2_ENABLED << RGB_LED2_EN_BIT) | 
+                        (RGB_LED3_ENABLED << RGB_LED3_EN_BIT) | 
+                        (RGB_LED4_ENABLED << RGB_LED4_EN_BIT));
             #endif
+                }
         {% endif %}
     {% endstrip %}
 }
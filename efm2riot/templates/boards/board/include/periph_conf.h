@@ -60,6 +60,29 @@ extern "C" {
     {% endif %}
 {% endstrip %}
 /** @} */
+{% strip 2 %}
+    {% if board in ["slstk3401a", "sltb001a"] %}
+
+        /**
+         * @brief   DC-DC converter configuration
+         *
+         * The DC-DC converter powers DVDD. The load currents (in mA for EM0/1,
+         * and in uA for EM2/3/4) are estimates, used to optimize the converter.
+         * Set the mode to emuDcdcMode_Bypass to power DVDD from VMCU directly.
+         * @{
+         */
+        #ifndef DCDC_MODE
+        #define DCDC_MODE           emuDcdcMode_LowNoise
+        #endif
+        #ifndef DCDC_EM01_LOAD
+        #define DCDC_EM01_LOAD      ({{ "15U" if board == "sltb001a" else "5U" }})
+        #endif
+        #ifndef DCDC_EM234_LOAD
+        #define DCDC_EM234_LOAD     (10U)
+        #endif
+        /** @} */
+    {% endif %}
+{% endstrip %}
 
 /**
  * @brief   ADC configuration
@@ -137,6 +160,29 @@ static const adc_chan_conf_t adc_channel_config[] = {
             }
         };
 
+        #define DAC_NUMOF           (1U)
+        /** @} */
+    {% elif vdac %}
+        /**
+         * @brief   DAC configuration
+         * @{
+         */
+        static const dac_conf_t dac_config[] = {
+            {
+                VDAC0,                              /* device */
+                cmuClock_VDAC0,                     /* CMU register */
+                VDAC_CTRL_REFSEL_VDD,               /* device reference */
+                true                                /* retain output in EM2/EM3 */
+            }
+        };
+
+        static const dac_chan_conf_t dac_channel_config[] = {
+            {
+                0,                                  /* DAC device index */
+                0                                   /* channel to use */
+            }
+        };
+
         #define DAC_NUMOF           (1U)
         /** @} */
     {% else %}
@@ -326,11 +372,30 @@ static const pwm_conf_t pwm_config[] = {
 
 {% strip 2 %}
     {% if cpu_platform == 1 %}
+        #if BURTC_ENABLED && defined(BURTC_COUNT)
+        #define RTT_MAX_VALUE       (0xFFFFFFFF)
+        #else
         #define RTT_MAX_VALUE       (0xFFFFFF)
-        #define RTT_FREQUENCY       (1U)
+        #endif
     {% else %}
         #define RTT_MAX_VALUE       (0xFFFFFFFF)
+    {% endif %}
+{% endstrip %}
+
+/* power of two, from 1 Hz up to 32768 Hz */
+{% strip 2 %}
+    {% if cpu_platform == 1 %}
+        #ifndef RTT_FREQUENCY
+        #if BURTC_ENABLED && defined(BURTC_COUNT)
+        #define RTT_FREQUENCY       (256U)  /* lowest BURTC frequency */
+        #else
         #define RTT_FREQUENCY       (1U)
+        #endif
+        #endif
+    {% else %}
+        #ifndef RTT_FREQUENCY
+        #define RTT_FREQUENCY       (1U)
+        #endif
     {% endif %}
 {% endstrip %}
 /** @} */
@@ -21,6 +21,7 @@
 
 #include <stdint.h>
 #include "vectors_cortexm.h"
+#include "isr_profile.h"
 
 /* get the start of the ISR stack as defined in the linkerscript */
 extern uint32_t _estack;
@@ -45,6 +46,34 @@ WEAK_DEFAULT void isr_systick(void);
     {% endfor %}
 {% endstrip %}
 
+#if ISR_PROFILE_ENABLED
+/* wrap each handler with a probe, that measures its duration */
+{% strip 3 %}
+    {% for irq in irqs %}
+        {% if not irq.reserved %}
+            ISR_PROFILE_PROBE({{ irq.method_name }}, {{ irq.number }})
+        {% endif %}
+    {% endfor %}
+{% endstrip %}
+
+/* names of the interrupts, as printed by isr_profile_cmd */
+const char *const isr_profile_names[EXT_IRQ_COUNT] = {
+    {% strip 3 %}
+        {% for irq in irqs %}
+            {% if irq.reserved %}
+                NULL,
+            {% else %}
+                "{{ irq.name }}",
+            {% endif %}
+        {% endfor %}
+    {% endstrip %}
+};
+
+#define HANDLER(name)       name ## _probe
+#else
+#define HANDLER(name)       name
+#endif
+
 /* interrupt vector table */
 ISR_VECTORS const void *interrupt_vector[] = {
     /* Exception stack pointer */
@@ -90,7 +119,7 @@ ISR_VECTORS const void *interrupt_vector[] = {
             {% if irq.reserved %}
                 (void*) (0UL),                  /* Reserved */
             {% else %}
-                (void*) {{ (irq.method_name ~ ",")|align(23) }} /* {{ irq.number }} - {{ irq.name }} */
+                (void*) {{ ("HANDLER(" ~ irq.method_name ~ "),")|align(23) }} /* {{ irq.number }} - {{ irq.name }} */
             {% endif %}
         {% endfor %}
     {% endstrip %}